@@ -0,0 +1,115 @@
+#include "admission_controller.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+AdmissionController::AdmissionController(const QString &filePath) : m_filePath(filePath) {
+    if (m_filePath.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_filePath = dir + "/compiler_memory.json";
+    }
+
+    bool ok = false;
+    const qint64 configured = qEnvironmentVariableIntValue("SYNTAXFLOW_MEMORY_BUDGET_MB", &ok);
+    setBudgetMB(ok && configured > 0 ? configured : defaultBudgetMB());
+}
+
+qint64 AdmissionController::defaultBudgetMB() {
+#ifdef Q_OS_UNIX
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) {
+        return qint64(pages) * pageSize / (1024 * 1024) * 3 / 4;
+    }
+#endif
+    return 4096;
+}
+
+qint64 AdmissionController::compileEstimateMB(const LanguageConfig &cfg) const {
+    if (!cfg.compiled) return 0;
+
+    const QList<qint64> peaks = m_compilePeaksMB.value(cfg.id);
+    if (peaks.isEmpty()) return DefaultCompileMB;
+    return *std::max_element(peaks.begin(), peaks.end());
+}
+
+bool AdmissionController::tryAdmit(qint64 mb) {
+    if (m_jobs > 0 && m_reservedMB + mb > m_budgetMB) {
+        m_stats.throttled++;
+        return false;
+    }
+    reserve(mb);
+    return true;
+}
+
+void AdmissionController::force(qint64 mb) {
+    reserve(mb);
+}
+
+void AdmissionController::reserve(qint64 mb) {
+    m_jobs++;
+    m_reservedMB += mb;
+    m_stats.admitted++;
+    m_stats.peakReservedMB = qMax(m_stats.peakReservedMB, m_reservedMB);
+}
+
+void AdmissionController::release(qint64 mb) {
+    m_jobs = qMax(0, m_jobs - 1);
+    m_reservedMB = m_jobs > 0 ? qMax<qint64>(0, m_reservedMB - mb) : 0;
+}
+
+void AdmissionController::recordCompilePeak(const LanguageConfig &cfg, qint64 peakKb) {
+    if (peakKb <= 0) return;
+
+    QList<qint64> &peaks = m_compilePeaksMB[cfg.id];
+    peaks.append((peakKb + 1023) / 1024);
+    while (peaks.size() > HistorySize) peaks.removeFirst();
+    m_dirty = true;
+}
+
+void AdmissionController::load() {
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    m_compilePeaksMB.clear();
+    for (auto it = root.begin(); it != root.end(); ++it) {
+        QList<qint64> peaks;
+        for (const QJsonValue &v : it.value().toArray()) peaks.append(v.toInteger());
+        if (!peaks.isEmpty()) m_compilePeaksMB.insert(it.key(), peaks);
+    }
+    m_dirty = false;
+}
+
+void AdmissionController::save() {
+    if (!m_dirty) return;
+
+    QJsonObject root;
+    for (auto it = m_compilePeaksMB.begin(); it != m_compilePeaksMB.end(); ++it) {
+        QJsonArray peaks;
+        for (qint64 mb : it.value()) peaks.append(mb);
+        root[it.key()] = peaks;
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save compiler memory history:" << m_filePath;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (file.commit()) m_dirty = false;
+}
@@ -0,0 +1,66 @@
+#ifndef ADMISSION_CONTROLLER_H
+#define ADMISSION_CONTROLLER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "language_config.h"
+
+// Keeps compiles and test runs from overcommitting memory. Every job
+// reserves an estimate before it starts and releases it when it is done:
+// a test run its language's memoryLimitMB, a compile the largest peak RSS
+// recently seen for that language's compiler (learned by sampling the
+// compiler's process group, persisted in the app data directory). A job is
+// admitted only while the reservations, its own included, fit the budget,
+// except that one job is always let through so nothing can stall.
+//
+// The budget defaults to three quarters of physical memory and can be set
+// with setBudgetMB() or the SYNTAXFLOW_MEMORY_BUDGET_MB environment variable.
+class AdmissionController {
+public:
+    explicit AdmissionController(const QString &filePath = QString());
+
+    static qint64 defaultBudgetMB();
+    qint64 budgetMB() const { return m_budgetMB; }
+    void setBudgetMB(qint64 mb) { m_budgetMB = qMax<qint64>(1, mb); }
+
+    qint64 compileEstimateMB(const LanguageConfig &cfg) const;
+    static qint64 runEstimateMB(const LanguageConfig &cfg) { return qMax(1, cfg.memoryLimitMB); }
+
+    // Reserves mb if it fits; false (and counted as throttled) otherwise
+    bool tryAdmit(qint64 mb);
+    // Reserves mb whether or not it fits, for jobs that can't wait
+    void force(qint64 mb);
+    void release(qint64 mb);
+    qint64 reservedMB() const { return m_reservedMB; }
+
+    void recordCompilePeak(const LanguageConfig &cfg, qint64 peakKb);
+
+    // Decisions since the last resetStats()
+    struct Stats {
+        int admitted = 0;
+        int throttled = 0;
+        qint64 peakReservedMB = 0;
+    };
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats{}; }
+
+    void load();
+    void save();
+
+private:
+    static constexpr int HistorySize = 8;
+    static constexpr qint64 DefaultCompileMB = 512;
+
+    void reserve(qint64 mb);
+
+    QHash<QString, QList<qint64>> m_compilePeaksMB;   // Language id -> recent peaks
+    QString m_filePath;
+    qint64 m_budgetMB = 0;
+    qint64 m_reservedMB = 0;
+    int m_jobs = 0;
+    Stats m_stats;
+    bool m_dirty = false;
+};
+
+#endif // ADMISSION_CONTROLLER_H
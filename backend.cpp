@@ -1,29 +1,32 @@
 #include "backend.h"
 #include "language_registry.h"
 #include "code_runner.h"
+#include "problem_repository.h"
 
 #include <QDesktopServices>
 #include <QUrl>
 #include <QFile>
 #include <QJsonDocument>
-#include <QJsonArray>
-#include <QDir>
-#include <QCoreApplication>
 #include <QDebug>
 
-Backend::Backend(QObject *parent) : QObject(parent) {
+Backend::Backend(ProblemRepository *problems, QObject *parent)
+    : QObject(parent), m_problems(problems) {
     m_registry = new LanguageRegistry(this);
-    m_runner = new CodeRunner(m_registry, this);
+    m_runner = new CodeRunner(m_registry, m_problems, this);
 
     m_registry->initialize();
 
     // Connect runner signals
     connect(m_runner, &CodeRunner::testResult, this, &Backend::testResult);
+    connect(m_runner, &CodeRunner::testResultCached, this, &Backend::testResultCached);
+    connect(m_runner, &CodeRunner::testSkipped, this, &Backend::testSkipped);
     connect(m_runner, &CodeRunner::compilationError, this, &Backend::compilationError);
+    connect(m_runner, &CodeRunner::buildDiagnostics, this, &Backend::buildDiagnostics);
     connect(m_runner, &CodeRunner::systemError, this, &Backend::systemError);
     connect(m_runner, &CodeRunner::started, this, &Backend::executionStarted);
     connect(m_runner, &CodeRunner::finished, this, &Backend::executionFinished);
     connect(m_runner, &CodeRunner::progress, this, &Backend::progress);
+    connect(m_runner, &CodeRunner::verdict, this, &Backend::executionVerdict);
 
     connect(m_registry, &LanguageRegistry::languagesChanged, this, &Backend::languagesChanged);
 
@@ -48,6 +51,10 @@ QString Backend::getTemplate(const QString &languageId) const {
     return m_registry->getConfig(languageId).codeTemplate;
 }
 
+QByteArray Backend::sourceHash(const QString &code, const QString &languageId) const {
+    return SpeculativeBuilder::sourceHash(code, m_registry->getConfig(languageId));
+}
+
 bool Backend::isLanguageAvailable(const QString &id) const {
     return m_registry->isLanguageAvailable(id);
 }
@@ -56,34 +63,30 @@ bool Backend::isRunning() const {
     return m_runner->isRunning();
 }
 
-void Backend::runCode(const QString &code, const QString &languageId, const QString &problemId) {
-    m_runner->runCode(code, languageId, problemId);
+void Backend::runCode(const QString &code, const QString &languageId, const QString &problemId,
+                      bool forceRerun, bool fullSuite) {
+    m_runner->runCode(code, languageId, problemId, forceRerun, fullSuite);
 }
 
 void Backend::runTestCase(const QString &code, const QString &languageId,
-                          int testIndex, const QString &problemId) {
-    m_runner->runSingleTest(code, languageId, testIndex, problemId);
+                          int testIndex, const QString &problemId, bool forceRerun) {
+    m_runner->runSingleTest(code, languageId, testIndex, problemId, forceRerun);
 }
 
 void Backend::stopExecution() {
     m_runner->stop();
 }
 
+void Backend::prepareBuild(const QString &code, const QString &languageId) {
+    m_runner->prepareSpeculativeBuild(code, languageId);
+}
+
 void Backend::requestTestCases(const QString &problemId) {
-    QString relPath = "/data/problems/" + problemId + ".json";
-    QStringList paths = {
-        QDir::currentPath(),
-        QCoreApplication::applicationDirPath(),
-        QCoreApplication::applicationDirPath() + "/../..",
-        QCoreApplication::applicationDirPath() + "/../../.."
-    };
-
-    for (const QString &p : paths) {
-        QString full = QDir(p).cleanPath(p + relPath);
-        QFile file(full);
-        if (file.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-            emit testCasesReady(doc.object()["testCases"].toArray());
+    const QString path = m_problems->resolve(problemId);
+    if (!path.isEmpty()) {
+        const ProblemRepository::Problem problem = m_problems->problem(path);
+        if (problem.isValid()) {
+            emit testCasesReady(problem.tests);
             return;
         }
     }
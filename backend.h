@@ -3,15 +3,18 @@
 
 #include <QObject>
 #include "language_config.h"
+#include "compile_diagnostics.h"
+#include "test_case_set.h"
 
 class LanguageRegistry;
 class CodeRunner;
+class ProblemRepository;
 
 class Backend : public QObject {
     Q_OBJECT
 
 public:
-    explicit Backend(QObject *parent = nullptr);
+    explicit Backend(ProblemRepository *problems, QObject *parent = nullptr);
     ~Backend();
 
     // Language info
@@ -20,16 +23,20 @@ public:
     LanguageConfig getLanguageConfig(const QString &id) const;
     QString getTemplate(const QString &languageId) const;
     bool isLanguageAvailable(const QString &id) const;
+    // Identifies code as background builds and buildDiagnostics() do
+    QByteArray sourceHash(const QString &code, const QString &languageId) const;
 
     // State
     bool isRunning() const;
 
 public slots:
     // Execution
-    void runCode(const QString &code, const QString &languageId, const QString &problemPath);
+    void runCode(const QString &code, const QString &languageId, const QString &problemPath,
+                 bool forceRerun = false, bool fullSuite = false);
     void runTestCase(const QString &code, const QString &languageId,
-                     int testIndex, const QString &problemPath);
+                     int testIndex, const QString &problemPath, bool forceRerun = false);
     void stopExecution();
+    void prepareBuild(const QString &code, const QString &languageId);
 
     // Test cases
     void requestTestCases(const QString &problemId);
@@ -44,14 +51,20 @@ signals:
     // Execution results
     void testResult(int testIndex, const QString &status, const QString &output,
                     const QString &expected, qint64 timeMs);
+    void testResultCached(int testIndex);
+    void testSkipped(int testIndex);
     void compilationError(const QString &error);
+    // From a background build; stale unless sourceHash matches the editor
+    void buildDiagnostics(const QByteArray &sourceHash, const QList<CompileDiagnostic> &diagnostics);
     void systemError(const QString &error);
     void executionStarted();
     void executionFinished();
     void progress(int current, int total);
+    // Tests accepted out of those the run selected; see CodeRunner::verdict
+    void executionVerdict(int passed, int selected);
 
     // Data
-    void testCasesReady(const QJsonArray &testCases);
+    void testCasesReady(const TestCases &testCases);
 
     // Config
     void languagesChanged();
@@ -59,6 +72,7 @@ signals:
 private:
     LanguageRegistry *m_registry;
     CodeRunner *m_runner;
+    ProblemRepository *m_problems;
 };
 
 #endif // BACKEND_H
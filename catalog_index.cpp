@@ -0,0 +1,455 @@
+#include "catalog_index.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char Magic[8] = {'S', 'F', 'C', 'A', 'T', 'I', 'D', 'X'};
+
+// FNV-1a, for the fingerprint
+quint64 mix(quint64 h, QByteArrayView bytes) {
+    for (char c : bytes) {
+        h ^= quint8(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+quint64 mix(quint64 h, qint64 value) {
+    return mix(h, QByteArrayView(reinterpret_cast<const char *>(&value), sizeof value));
+}
+
+void put16(QByteArray &out, quint16 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void put32(QByteArray &out, quint32 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void put64(QByteArray &out, quint64 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void set32(QByteArray &out, qsizetype pos, quint32 v) {
+    qToLittleEndian(v, out.data() + pos);
+}
+
+// Deduplicating string table
+class StringTable {
+public:
+    quint32 add(const QString &s) {
+        auto it = m_offsets.constFind(s);
+        if (it != m_offsets.constEnd()) return *it;
+        const quint32 offset = quint32(m_bytes.size());
+        const QByteArray utf8 = s.toUtf8();
+        put32(m_bytes, quint32(utf8.size()));
+        m_bytes.append(utf8);
+        m_offsets.insert(s, offset);
+        return offset;
+    }
+    const QByteArray &bytes() const { return m_bytes; }
+
+private:
+    QHash<QString, quint32> m_offsets;
+    QByteArray m_bytes;
+};
+
+} // namespace
+
+quint64 CatalogIndex::fingerprint(const QString &catalogPath, const QString &problemsDir) {
+    quint64 h = 14695981039346656037ULL;
+    h = mix(h, QFileInfo(catalogPath).absoluteFilePath().toUtf8());
+
+    const QFileInfo catalog(catalogPath);
+    h = mix(h, catalog.size());
+    h = mix(h, catalog.lastModified().toMSecsSinceEpoch());
+
+    // Adding, removing or renaming a problem file touches its directory.
+    // Only the directories are stat'ed, not every file: this runs on the
+    // GUI thread at startup.
+    QStringList dirs = {problemsDir};
+    QDirIterator it(problemsDir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) dirs.append(it.next());
+    std::sort(dirs.begin(), dirs.end());
+    for (const QString &dir : dirs) {
+        h = mix(h, dir.toUtf8());
+        h = mix(h, QFileInfo(dir).lastModified().toMSecsSinceEpoch());
+    }
+    return h;
+}
+
+quint64 CatalogIndex::hash(const QByteArray &bytes) {
+    const QByteArray digest = QCryptographicHash::hash(bytes, QCryptographicHash::Sha256);
+    return qFromLittleEndian<quint64>(digest.constData()) | 1;   // 0 means missing
+}
+
+quint64 CatalogIndex::hashFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    return hash(file.readAll());
+}
+
+bool CatalogIndex::build(const QString &catalogPath, const QString &problemsDir,
+                         const QString &indexPath, QString &error,
+                         const QHash<QString, FileInfo> &known) {
+    QFile file(catalogPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "Cannot open " + catalogPath;
+        return false;
+    }
+    const quint64 sourceFingerprint = fingerprint(catalogPath, problemsDir);
+    const QJsonArray problems = QJsonDocument::fromJson(file.readAll()).array();
+    file.close();
+
+    StringTable strings;
+    QStringList difficulties = {"Easy", "Medium", "Hard"};
+    QStringList topics;
+    QHash<QString, int> topicIds;
+    QByteArray records;
+    QByteArray topicRefs;
+    QList<QPair<QString, quint32>> byId;
+    quint64 contentHash = 14695981039346656037ULL;
+
+    for (const QJsonValue &value : problems) {
+        const QJsonObject obj = value.toObject();
+        const QString id = obj["id"].toString();
+        const QString path = obj["path"].toString();
+
+        // The problem file itself adds the category and identifies its version
+        QFile problemFile(QDir(problemsDir).filePath(path));
+        quint64 fileHash = 0;
+        QString category;
+        auto reuse = known.constFind(path);
+        if (reuse != known.constEnd()) {
+            fileHash = reuse->contentHash;
+            category = reuse->category;
+        } else if (problemFile.open(QIODevice::ReadOnly)) {
+            const QByteArray bytes = problemFile.readAll();
+            fileHash = hash(bytes);
+            category = QJsonDocument::fromJson(bytes).object()["category"].toString();
+        }
+
+        // Records hold a byte per difficulty and u16 topic ids; a catalog
+        // past that is refused rather than given aliased names
+        QString difficulty = obj["difficulty"].toString();
+        int difficultyId = difficulties.indexOf(difficulty);
+        if (difficultyId < 0) {
+            if (difficulties.size() > MaxDifficulties) {
+                error = QString("More than %1 difficulties in %2").arg(MaxDifficulties + 1).arg(catalogPath);
+                return false;
+            }
+            difficultyId = difficulties.size();
+            difficulties.append(difficulty);
+        }
+
+        const quint32 topicsBegin = quint32(topicRefs.size() / 2);
+        const QJsonArray topicArray = obj["topics"].toArray();
+        if (topicArray.size() > MaxTopics) {
+            error = QString("Problem %1 has more than %2 topics").arg(id).arg(MaxTopics);
+            return false;
+        }
+        for (const QJsonValue &t : topicArray) {
+            const QString topic = t.toString();
+            auto it = topicIds.constFind(topic);
+            if (it == topicIds.constEnd()) {
+                if (topics.size() > MaxTopics) {
+                    error = QString("More than %1 topics in %2").arg(MaxTopics + 1).arg(catalogPath);
+                    return false;
+                }
+                it = topicIds.insert(topic, topics.size());
+                topics.append(topic);
+            }
+            put16(topicRefs, quint16(*it));
+        }
+
+        byId.append({id, quint32(byId.size())});
+        put32(records, strings.add(id));
+        put32(records, strings.add(obj["title"].toString()));
+        put32(records, strings.add(path));
+        put32(records, strings.add(category));
+        put32(records, topicsBegin);
+        put16(records, quint16(topicArray.size()));
+        records.append(char(difficultyId));
+        records.append('\0');
+        put64(records, fileHash);
+
+        contentHash = mix(contentHash, id.toUtf8());
+        contentHash = mix(contentHash, qint64(fileHash));
+    }
+
+    std::sort(byId.begin(), byId.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    QByteArray names;
+    for (const QString &topic : topics) put32(names, strings.add(topic));
+    const quint32 difficultyNames = quint32(names.size());
+    for (const QString &difficulty : difficulties) put32(names, strings.add(difficulty));
+
+    QByteArray out(Magic, sizeof Magic);
+    put32(out, Version);
+    put32(out, quint32(problems.size()));
+    put32(out, quint32(topics.size()));
+    put32(out, quint32(difficulties.size()));
+    put64(out, sourceFingerprint);
+    put64(out, contentHash);
+    const qsizetype offsets = out.size();
+    out.resize(HeaderSize, '\0');
+
+    set32(out, offsets, quint32(out.size()));
+    out.append(records);
+    set32(out, offsets + 4, quint32(out.size()));
+    out.append(topicRefs);
+    out.resize((out.size() + 3) & ~qsizetype(3), '\0');
+    set32(out, offsets + 8, quint32(out.size()));
+    for (const auto &entry : byId) put32(out, entry.second);
+    set32(out, offsets + 12, quint32(out.size()));
+    set32(out, offsets + 16, quint32(out.size()) + difficultyNames);
+    out.append(names);
+    set32(out, offsets + 20, quint32(out.size()));
+    out.append(strings.bytes());
+
+    QSaveFile index(indexPath);
+    if (!index.open(QIODevice::WriteOnly)) {
+        error = "Cannot write " + indexPath;
+        return false;
+    }
+    index.write(out);
+    if (!index.commit()) {
+        error = "Cannot write " + indexPath;
+        return false;
+    }
+
+    qDebug() << "Built catalog index:" << problems.size() << "problems," << out.size() << "bytes";
+    return true;
+}
+
+bool CatalogIndex::open(const QString &catalogPath, const QString &problemsDir, const QString &indexPath) {
+    close();
+    m_catalogPath = catalogPath;
+    m_problemsDir = problemsDir;
+
+    QString path = indexPath;
+    if (path.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        path = dir + "/catalog.idx";
+    }
+
+    const quint64 expected = fingerprint(catalogPath, problemsDir);
+    if (map(path, expected)) return true;
+
+    QString error;
+    if (!build(catalogPath, problemsDir, path, error)) {
+        qWarning() << "Failed to build the catalog index:" << error;
+        return false;
+    }
+    return map(path, expected);
+}
+
+bool CatalogIndex::refresh(const QSet<QString> &changedFiles) {
+    if (m_catalogPath.isEmpty()) return false;
+
+    QHash<QString, FileInfo> known;
+    const QDir base(m_problemsDir);
+    for (int i = 0; i < size(); ++i) {
+        const Entry e = entry(i);
+        if (e.contentHash == 0) continue;   // Missing before; maybe added since
+        if (changedFiles.contains(QDir::cleanPath(base.absoluteFilePath(e.path)))) continue;
+        known.insert(e.path, {e.contentHash, e.category});
+    }
+
+    // Built beside the current index and checked by mapping it; until then
+    // the old mapping stays in use, so a failed rebuild loses nothing
+    const QString indexPath = m_file.fileName();
+    const QString freshPath = indexPath + ".new";
+    QString error;
+    if (!build(m_catalogPath, m_problemsDir, freshPath, error, known)) {
+        qWarning() << "Failed to rebuild the catalog index:" << error;
+        QFile::remove(freshPath);
+        return false;
+    }
+    const quint64 expected = fingerprint(m_catalogPath, m_problemsDir);
+    {
+        CatalogIndex fresh;
+        if (!fresh.map(freshPath, expected)) {
+            qWarning() << "Rebuilt catalog index is unusable:" << freshPath;
+            QFile::remove(freshPath);
+            return false;
+        }
+    }
+
+    // Unmapped before the swap so it also works where a mapped file cannot
+    // be replaced. If the rename fails the new file is used where it is.
+    close();
+    QFile::remove(indexPath);
+    if (QFile::rename(freshPath, indexPath)) return map(indexPath, expected);
+    qWarning() << "Cannot replace" << indexPath << "- using" << freshPath;
+    return map(freshPath, expected);
+}
+
+bool CatalogIndex::map(const QString &indexPath, quint64 fingerprint) {
+    m_file.setFileName(indexPath);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+    const qint64 size = m_file.size();
+    const uchar *data = size >= HeaderSize ? m_file.map(0, size) : nullptr;
+    if (!data || qFromLittleEndian<quint64>(data + 24) != fingerprint) {
+        if (data) m_file.unmap(const_cast<uchar *>(data));
+        close();
+        return false;
+    }
+    if (!attach(data, size)) {
+        qWarning() << "Corrupt catalog index:" << indexPath;
+        m_file.unmap(const_cast<uchar *>(data));
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool CatalogIndex::openData(const uchar *data, qint64 size) {
+    close();
+    m_catalogPath.clear();
+    m_problemsDir.clear();
+    if (!attach(data, size)) {
+        qWarning() << "Corrupt catalog index in memory";
+        return false;
+    }
+    return true;
+}
+
+bool CatalogIndex::attach(const uchar *data, qint64 size) {
+    if (!data || size < HeaderSize || memcmp(data, Magic, sizeof Magic) != 0 ||
+        qFromLittleEndian<quint32>(data + 8) != Version) {
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_count = read32(12);
+    m_contentHash = qFromLittleEndian<quint64>(data + 32);
+    m_records = read32(40);
+    m_topicIds = read32(44);
+    m_byId = read32(48);
+    m_strings = read32(60);
+    const quint32 topicCount = read32(16);
+    const quint32 difficultyCount = read32(20);
+    const quint32 topicNames = read32(52);
+    const quint32 difficultyNames = read32(56);
+
+    if (m_records + qint64(m_count) * RecordSize > m_size || m_byId + qint64(m_count) * 4 > m_size ||
+        topicNames + qint64(topicCount) * 4 > m_size || difficultyNames + qint64(difficultyCount) * 4 > m_size ||
+        m_strings > m_size) {
+        m_data = nullptr;
+        m_size = 0;
+        return false;
+    }
+
+    for (quint32 i = 0; i < topicCount; ++i) m_topics.append(string(read32(topicNames + 4 * i)));
+    for (quint32 i = 0; i < difficultyCount; ++i) m_difficulties.append(string(read32(difficultyNames + 4 * i)));
+    return true;
+}
+
+void CatalogIndex::close() {
+    if (m_data && m_file.isOpen()) m_file.unmap(const_cast<uchar *>(m_data));
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_contentHash = 0;
+    m_difficulties.clear();
+    m_topics.clear();
+}
+
+quint32 CatalogIndex::read32(qint64 pos) const {
+    return qFromLittleEndian<quint32>(m_data + pos);
+}
+
+QString CatalogIndex::string(quint32 offset) const {
+    const qint64 pos = qint64(m_strings) + offset;
+    if (pos + 4 > m_size) return QString();
+    const quint32 length = read32(pos);
+    if (pos + 4 + length > m_size) return QString();
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_data + pos + 4), length);
+}
+
+const uchar *CatalogIndex::record(int index) const {
+    return m_data + m_records + qint64(index) * RecordSize;
+}
+
+QString CatalogIndex::id(int index) const {
+    return string(qFromLittleEndian<quint32>(record(index)));
+}
+
+QString CatalogIndex::path(int index) const {
+    return string(qFromLittleEndian<quint32>(record(index) + 8));
+}
+
+int CatalogIndex::difficultyId(int index) const {
+    return record(index)[22];
+}
+
+QList<int> CatalogIndex::topicIds(int index) const {
+    const uchar *r = record(index);
+    const quint32 begin = qFromLittleEndian<quint32>(r + 16);
+    const quint16 count = qFromLittleEndian<quint16>(r + 20);
+    QList<int> ids;
+    if (m_topicIds + (qint64(begin) + count) * 2 > m_size) return ids;
+    ids.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        ids.append(qFromLittleEndian<quint16>(m_data + m_topicIds + (begin + i) * 2));
+    }
+    return ids;
+}
+
+quint64 CatalogIndex::contentHash(int index) const {
+    return qFromLittleEndian<quint64>(record(index) + 24);
+}
+
+CatalogIndex::Entry CatalogIndex::entry(int index) const {
+    const uchar *r = record(index);
+    Entry e;
+    e.id = string(qFromLittleEndian<quint32>(r));
+    e.title = string(qFromLittleEndian<quint32>(r + 4));
+    e.path = string(qFromLittleEndian<quint32>(r + 8));
+    e.category = string(qFromLittleEndian<quint32>(r + 12));
+    e.difficulty = m_difficulties.value(difficultyId(index));
+    for (int topic : topicIds(index)) e.topics.append(m_topics.value(topic));
+    e.contentHash = contentHash(index);
+    return e;
+}
+
+int CatalogIndex::find(const QString &id) const {
+    int lo = 0;
+    int hi = int(m_count);
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        const int index = int(read32(m_byId + 4 * qint64(mid)));
+        if (this->id(index) < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < int(m_count)) {
+        const int index = int(read32(m_byId + 4 * qint64(lo)));
+        if (this->id(index) == id) return index;
+    }
+    return -1;
+}
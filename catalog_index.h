@@ -0,0 +1,123 @@
+#ifndef CATALOG_INDEX_H
+#define CATALOG_INDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Binary index of the problem catalog: problems.json plus what the browser
+// needs from each problems/*/*.json, compiled into one file that is mapped
+// instead of parsed. Opening it reads the 64-byte header and the topic and
+// difficulty names; records are decoded on demand.
+//
+// Layout (little-endian):
+//   header      magic, version, counts, source fingerprint, content hash
+//               and the offsets of the sections below
+//   records     32 bytes per problem, in catalog order: string offsets of
+//               id, title, path and category, the problem's topic ids, its
+//               difficulty id and the hash of its problem file
+//   topic ids   u16 per topic reference, shared by all records
+//   by id       u32 record numbers sorted by id, for find()
+//   names       string offsets of the topic and difficulty names
+//   strings     u32 length + UTF-8 bytes each
+//
+// The fingerprint covers the size and modification time of problems.json
+// and of the problem directories, so open() rebuilds a stale index on its
+// own when problems are added, removed or renamed. A problem file edited in
+// place leaves its directory untouched; the repository catches it when the
+// file is next read and its content hash differs from its record's.
+class CatalogIndex {
+public:
+    struct Entry {
+        QString id;
+        QString title;
+        QString difficulty;
+        QString path;          // Relative to the problems directory
+        QString category;
+        QStringList topics;
+        quint64 contentHash = 0;   // Of the problem file, 0 when it is missing
+    };
+
+    // What a record keeps from its problem file
+    struct FileInfo {
+        quint64 contentHash = 0;
+        QString category;
+    };
+
+    CatalogIndex() = default;
+    ~CatalogIndex() { close(); }
+    CatalogIndex(const CatalogIndex &) = delete;
+    CatalogIndex &operator=(const CatalogIndex &) = delete;
+
+    // Maps the index of catalogPath, building it first when it is missing
+    // or stale. indexPath defaults to catalog.idx in the app data directory.
+    bool open(const QString &catalogPath, const QString &problemsDir,
+              const QString &indexPath = QString());
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Rebuilds the open index after problems.json or problem files changed.
+    // Only the files in changedFiles (absolute paths) and new ones are read;
+    // the rest keep what the current index has. On failure the current
+    // index stays open as it was.
+    bool refresh(const QSet<QString> &changedFiles);
+
+    // Uses an index held in memory the caller keeps alive, e.g. an entry of
+    // a mapped problem pack; no staleness check, packs do not change
+    bool openData(const uchar *data, qint64 size);
+
+    int size() const { return int(m_count); }
+    quint64 contentHash() const { return m_contentHash; }
+
+    Entry entry(int index) const;
+    QString id(int index) const;
+    QString path(int index) const;
+    int difficultyId(int index) const;
+    QList<int> topicIds(int index) const;
+    quint64 contentHash(int index) const;
+
+    const QStringList &difficulties() const { return m_difficulties; }
+    const QStringList &topics() const { return m_topics; }
+
+    // Record number of the problem with this id, -1 if there is none
+    int find(const QString &id) const;
+
+    static quint64 fingerprint(const QString &catalogPath, const QString &problemsDir);
+    // Content hash as stored in the records; never 0
+    static quint64 hash(const QByteArray &bytes);
+    static quint64 hashFile(const QString &path);
+    static bool build(const QString &catalogPath, const QString &problemsDir,
+                      const QString &indexPath, QString &error,
+                      const QHash<QString, FileInfo> &known = {});
+
+private:
+    static constexpr quint32 Version = 1;
+    static constexpr int HeaderSize = 64;
+    static constexpr int RecordSize = 32;
+    static constexpr int MaxDifficulties = 0xff;   // Highest id a record can hold
+    static constexpr int MaxTopics = 0xffff;
+
+    quint32 read32(qint64 pos) const;
+    QString string(quint32 offset) const;
+    const uchar *record(int index) const;
+    bool map(const QString &indexPath, quint64 fingerprint);
+    bool attach(const uchar *data, qint64 size);
+
+    QString m_catalogPath;
+    QString m_problemsDir;
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    quint32 m_count = 0;
+    quint64 m_contentHash = 0;
+    quint32 m_records = 0;
+    quint32 m_topicIds = 0;
+    quint32 m_byId = 0;
+    quint32 m_strings = 0;
+    QStringList m_difficulties;
+    QStringList m_topics;
+};
+
+#endif // CATALOG_INDEX_H
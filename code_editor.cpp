@@ -16,6 +16,13 @@ CodeEditor::CodeEditor(QWidget *parent)
     connect(this, &CodeEditor::cursorPositionChanged,
             this, &CodeEditor::highlightCurrentLine);
 
+    // Debounce edits into a single "typing stopped" notification
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(IdleDelayMs);
+    connect(idleTimer, &QTimer::timeout, this, &CodeEditor::typingIdle);
+    connect(this, &CodeEditor::textChanged, this, &CodeEditor::onTextChanged);
+
     updateLineNumberAreaWidth(0);
     highlightCurrentLine();
 
@@ -143,11 +150,9 @@ void CodeEditor::resizeEvent(QResizeEvent *e)
 
 void CodeEditor::highlightCurrentLine()
 {
-    if (!highlightCurrentLineEnabled) return;
-
     QList<QTextEdit::ExtraSelection> extraSelections;
 
-    if (!isReadOnly()) {
+    if (highlightCurrentLineEnabled && !isReadOnly()) {
         QTextEdit::ExtraSelection selection;
 
         // Current line highlight color
@@ -160,9 +165,44 @@ void CodeEditor::highlightCurrentLine()
         extraSelections.append(selection);
     }
 
+    // Compiler diagnostics
+    for (const CompileDiagnostic &d : diagnostics) {
+        QTextBlock block = document()->findBlockByNumber(d.line - 1);
+        if (!block.isValid()) continue;
+
+        QTextEdit::ExtraSelection selection;
+        QColor color = d.severity == "warning" ? QColor("#e5c07b") : QColor("#f38ba8");
+        selection.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+        selection.format.setUnderlineColor(color);
+        selection.cursor = QTextCursor(block);
+        selection.cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        extraSelections.append(selection);
+    }
+
     setExtraSelections(extraSelections);
 }
 
+void CodeEditor::onTextChanged()
+{
+    // Line numbers are stale as soon as the text moves
+    if (!diagnostics.isEmpty()) clearDiagnostics();
+    idleTimer->start();
+}
+
+void CodeEditor::setDiagnostics(const QList<CompileDiagnostic> &newDiagnostics)
+{
+    diagnostics = newDiagnostics;
+    highlightCurrentLine();
+    lineNumberArea->update();
+}
+
+void CodeEditor::clearDiagnostics()
+{
+    diagnostics.clear();
+    highlightCurrentLine();
+    lineNumberArea->update();
+}
+
 void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
 {
     QPainter painter(lineNumberArea);
@@ -191,8 +231,18 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
         if (block.isVisible() && bottom >= event->rect().top()) {
             QString number = QString::number(blockNumber + 1);
 
+            bool hasError = false;
+            for (const CompileDiagnostic &d : diagnostics) {
+                if (d.line == blockNumber + 1 && d.severity == "error") {
+                    hasError = true;
+                    break;
+                }
+            }
+
             // Highlight current line number
-            if (blockNumber == currentLine) {
+            if (hasError) {
+                painter.setPen(QColor("#f38ba8"));  // Compiler error on this line
+            } else if (blockNumber == currentLine) {
                 painter.setPen(QColor("#cdd6f4"));  // Bright for current line
 
                 // Draw highlight background for current line number
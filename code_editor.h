@@ -5,6 +5,8 @@
 #include <QWidget>
 #include <QPainter>
 #include <QTextBlock>
+#include <QTimer>
+#include "compile_diagnostics.h"
 
 class LineNumberArea;
 
@@ -22,6 +24,14 @@ public:
     void setCurrentLineHighlight(bool enabled);
     void setTabWidth(int spaces);
 
+    // Marks lines reported by the compiler; cleared on the next edit
+    void setDiagnostics(const QList<CompileDiagnostic> &diagnostics);
+    void clearDiagnostics();
+
+signals:
+    // Emitted once typing has stopped for IdleDelayMs
+    void typingIdle();
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
@@ -30,12 +40,17 @@ private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
     void highlightCurrentLine();
     void updateLineNumberArea(const QRect &rect, int dy);
+    void onTextChanged();
 
 private:
     LineNumberArea *lineNumberArea;
     bool showLineNumbers = true;
     bool highlightCurrentLineEnabled = true;
     int tabSpaces = 4;
+
+    static constexpr int IdleDelayMs = 600;
+    QTimer *idleTimer;
+    QList<CompileDiagnostic> diagnostics;
 };
 
 // ═══════════════════════════════════════════════════════════════
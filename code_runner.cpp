@@ -1,19 +1,78 @@
 #include "code_runner.h"
 #include "language_registry.h"
+#include "problem_repository.h"
+#include "process_group.h"
 #include <QDir>
 #include <QFile>
-#include <QJsonDocument>
+#include <QFileInfo>
 #include <QJsonObject>
 #include <QStandardPaths>
 #include <QDateTime>
 #include <QElapsedTimer>
-#include <QCoreApplication>
+#include <QHash>
+#include <QThread>
 #include <QDebug>
 #include "output_normalizer.h"
-CodeRunner::CodeRunner(LanguageRegistry *registry, QObject *parent)
-    : QObject(parent), m_registry(registry) {}
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <future>
 
-void CodeRunner::runCode(const QString &code, const QString &languageId, const QString &problemPath) {
+namespace {
+
+// Outputs beyond this are cut for display instead of converted whole
+constexpr qsizetype DisplayLimitBytes = 64 * 1024;
+
+// Context shown on each side of the first difference in a large output
+constexpr qsizetype DiffContextBytes = 512;
+
+// Inputs this large make a test a max test, run last on Submit
+constexpr qsizetype MaxTestInputBytes = 64 * 1024;
+
+// How often a foreground compile's memory is sampled
+constexpr int CompileSampleMs = 100;
+
+// Outputs at least this large are compared off the runner thread; smaller
+// ones cost less to compare than to hand over
+constexpr qint64 DeferCompareBytes = 256 * 1024;
+
+QString preview(QByteArrayView bytes) {
+    if (bytes.size() <= DisplayLimitBytes) return QString::fromUtf8(bytes).trimmed();
+    return QString::fromUtf8(bytes.first(DisplayLimitBytes)).trimmed() +
+           QString("\n... (%1 bytes, truncated)").arg(bytes.size());
+}
+
+QString window(QByteArrayView bytes, qsizetype pos) {
+    const qsizetype from = qMax<qsizetype>(0, pos - DiffContextBytes);
+    const qsizetype to = qMin(bytes.size(), pos + DiffContextBytes);
+    return (from > 0 ? QString("... ") : QString()) +
+           QString::fromUtf8(bytes.sliced(from, to - from)) +
+           (to < bytes.size() ? QString(" ...") : QString());
+}
+
+QString readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? preview(file.read(DisplayLimitBytes + 1)) : QString();
+}
+
+} // namespace
+
+CodeRunner::CodeRunner(LanguageRegistry *registry, ProblemRepository *problems, QObject *parent)
+    : QObject(parent), m_registry(registry), m_problems(problems) {
+    m_builder = new SpeculativeBuilder(this);
+    m_jvmHost = new JvmHost(this);
+    m_nativeHarness = new NativeHarness(this);
+    m_builder->setAdmission(&m_admission);
+    connect(m_builder, &SpeculativeBuilder::diagnosticsReady,
+            this, &CodeRunner::buildDiagnostics);
+
+    m_resultCache.load();
+    m_admission.load();
+    m_testStats.load();
+}
+
+void CodeRunner::runCode(const QString &code, const QString &languageId, const QString &problemPath,
+                         bool forceRerun, bool fullSuite) {
     if (m_running) {
         emit systemError("Already running");
         return;
@@ -21,6 +80,13 @@ void CodeRunner::runCode(const QString &code, const QString &languageId, const Q
 
     m_running = true;
     m_stopRequested = false;
+    m_aborted = false;
+    m_earlyAbort = true;
+    m_problemKey = QFileInfo(problemPath).completeBaseName();
+    m_metrics.reset();
+    m_admission.resetStats();
+    m_timeline.start();
+    m_forceRerun = forceRerun;
     emit started();
 
     // Get config
@@ -40,39 +106,30 @@ void CodeRunner::runCode(const QString &code, const QString &languageId, const Q
         return;
     }
 
-    // Setup
-    QString dir = createWorkDir(languageId);
-    if (dir.isEmpty()) {
-        emit systemError("Failed to create temp directory");
-        m_running = false;
-        emit finished();
-        return;
+    // Warm JVM boots while javac runs; the warm hosts run outside the sandbox
+    if (cfg.runner == "jvm-host" && !Sandbox::isRequested()) {
+        m_jvmHost->start(cfg);
     }
-    m_workDir = dir;
 
-    if (!writeSource(dir, code, cfg)) {
-        emit systemError("Failed to write source file");
-        cleanup(dir);
+    // Setup & compile; tests are loaded and prepared meanwhile
+    QList<PreparedTest> tests;
+    bool loaded = false;
+    auto load = [&]() { loaded = loadTests(problemPath, tests); };
+
+    QString dir;
+    if (!setupWorkDir(code, cfg, dir, load)) {
+        m_jvmHost->stop();
         m_running = false;
         emit finished();
         return;
     }
 
-    // Compile
-    if (cfg.compiled) {
-        QString error;
-        if (!compile(dir, cfg, error)) {
-            emit compilationError(error);
-            cleanup(dir);
-            m_running = false;
-            emit finished();
-            return;
-        }
+    // Warm image the C/C++ tests fork from
+    if (NativeHarness::isEnabled(cfg) && !Sandbox::isRequested()) {
+        m_nativeHarness->start(cfg, dir);
     }
 
-    // Load tests
-    QJsonArray tests;
-    if (!loadTestCases(problemPath, tests)) {
+    if (!loaded) {
         emit systemError("Failed to load test cases from: " + problemPath);
         cleanup(dir);
         m_running = false;
@@ -80,21 +137,54 @@ void CodeRunner::runCode(const QString &code, const QString &languageId, const Q
         return;
     }
 
-    qDebug() << "Loaded" << tests.size() << "test cases";
+    // Submit settles for the core tier; its coverage matches the full suite
+    if (!fullSuite) {
+        int core = 0;
+        for (PreparedTest &prepared : tests) {
+            prepared.selected = !prepared.extended;
+            if (prepared.selected) core++;
+        }
+        if (core < tests.size()) qDebug() << "Running the core tier:" << core << "of" << tests.size() << "tests";
+    }
 
     // Run tests
-    for (int i = 0; i < tests.size() && !m_stopRequested; ++i) {
-        emit progress(i + 1, tests.size());
-        executeTest(dir, cfg, tests[i].toObject(), i);
+    if (m_multiTest != MultiTest::None && tests.size() > 1) {
+        runTestsBatched(dir, cfg, tests);
+    } else if (canRunConcurrently(cfg)) {
+        runTestsConcurrently(cfg, tests);
+    } else {
+        runTestsSequentially(dir, cfg, tests);
     }
 
+    if (m_aborted) qDebug() << "Stopped at the first failing test";
+    if (!m_stopRequested) {
+        reportSkipped(tests);
+
+        // Judged against the tier that ran, not the full list of tests
+        int passed = 0, selected = 0;
+        for (const PreparedTest &prepared : tests) {
+            if (!prepared.selected) continue;
+            selected++;
+            if (prepared.accepted) passed++;
+        }
+        emit verdict(passed, selected);
+    }
+
+    m_resultCache.save();
+    m_testStats.save();
+    m_admission.save();
+    m_metrics.memoryAdmitted = m_admission.stats().admitted;
+    m_metrics.memoryThrottled = m_admission.stats().throttled;
+    m_metrics.peakReservedMB = m_admission.stats().peakReservedMB;
+    qDebug() << "Run finished:" << m_metrics;
+    qDebug() << m_timeline;
     cleanup(dir);
     m_running = false;
     emit finished();
 }
 
 void CodeRunner::runSingleTest(const QString &code, const QString &languageId,
-                               int testIndex, const QString &problemPath) {
+                               int testIndex, const QString &problemPath, bool forceRerun) {
     if (m_running) {
         emit systemError("Already running");
         return;
@@ -102,6 +192,13 @@ void CodeRunner::runSingleTest(const QString &code, const QString &languageId,
 
     m_running = true;
     m_stopRequested = false;
+    m_aborted = false;
+    m_earlyAbort = false;
+    m_problemKey = QFileInfo(problemPath).completeBaseName();
+    m_metrics.reset();
+    m_admission.resetStats();
+    m_timeline.start();
+    m_forceRerun = forceRerun;
     emit started();
 
     LanguageConfig cfg = m_registry->getConfig(languageId);
@@ -112,28 +209,27 @@ void CodeRunner::runSingleTest(const QString &code, const QString &languageId,
         return;
     }
 
-    QString dir = createWorkDir(languageId);
-    if (dir.isEmpty() || !writeSource(dir, code, cfg)) {
-        emit systemError("Setup failed");
+    if (cfg.runner == "jvm-host" && !Sandbox::isRequested()) {
+        m_jvmHost->start(cfg);
+    }
+
+    QList<PreparedTest> tests;
+    bool loaded = false;
+    auto load = [&]() { loaded = loadTests(problemPath, tests); };
+
+    QString dir;
+    if (!setupWorkDir(code, cfg, dir, load)) {
+        m_jvmHost->stop();
         m_running = false;
         emit finished();
         return;
     }
-    m_workDir = dir;
 
-    if (cfg.compiled) {
-        QString error;
-        if (!compile(dir, cfg, error)) {
-            emit compilationError(error);
-            cleanup(dir);
-            m_running = false;
-            emit finished();
-            return;
-        }
+    if (NativeHarness::isEnabled(cfg) && !Sandbox::isRequested()) {
+        m_nativeHarness->start(cfg, dir);
     }
 
-    QJsonArray tests;
-    if (!loadTestCases(problemPath, tests)) {
+    if (!loaded) {
         qDebug() << "Failed to load test cases from:" << problemPath;
         emit systemError("Failed to load test cases from: " + problemPath);
         cleanup(dir);
@@ -152,18 +248,137 @@ void CodeRunner::runSingleTest(const QString &code, const QString &languageId,
         return;
     }
 
-    executeTest(dir, cfg, tests[testIndex].toObject(), testIndex);
+    executeTest(dir, cfg, tests[testIndex]);
 
+    m_resultCache.save();
+    m_testStats.save();
+    m_admission.save();
+    m_metrics.memoryAdmitted = m_admission.stats().admitted;
+    m_metrics.memoryThrottled = m_admission.stats().throttled;
+    m_metrics.peakReservedMB = m_admission.stats().peakReservedMB;
+    qDebug() << "Run finished:" << m_metrics;
+    qDebug() << m_timeline;
     cleanup(dir);
     m_running = false;
     emit finished();
 }
 
+void CodeRunner::prepareSpeculativeBuild(const QString &code, const QString &languageId) {
+    if (m_running) return;
+
+    LanguageConfig cfg = m_registry->getConfig(languageId);
+    if (!cfg.compiled || !m_registry->isLanguageAvailable(languageId)) return;
+
+    m_builder->request(code, cfg);
+}
+
+bool CodeRunner::setupWorkDir(const QString &code, const LanguageConfig &cfg, QString &dir,
+                              const std::function<void()> &whileCompiling) {
+    bool overlapped = false;
+    auto overlap = [&]() {
+        if (!overlapped) {
+            overlapped = true;
+            whileCompiling();
+        }
+    };
+
+    // Reuse the background build if the editor contents have not changed since
+    if (cfg.compiled) {
+        const QByteArray hash = SpeculativeBuilder::sourceHash(code, cfg);
+        if (m_builder->has(hash)) {
+            // It may still be compiling
+            overlap();
+        }
+        const qint64 start = m_timeline.nowUs();
+        SpeculativeBuild build = m_builder->take(hash, cfg.compileTimeout);
+        if (!build.dir.isEmpty()) {
+            m_timeline.add("compile (bg)", start, m_timeline.nowUs());
+            qDebug() << "Using speculative build:" << build.dir;
+            m_workDir = build.dir;
+            if (!build.success) {
+                emit compilationError(build.error);
+                cleanup(build.dir);
+                return false;
+            }
+            dir = build.dir;
+            m_artifactHash = ResultCache::artifactHash(dir, cfg);
+            if (!buildLaunchSpec(cfg, dir)) {
+                cleanup(dir);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    dir = createWorkDir(cfg.id);
+    if (dir.isEmpty()) {
+        emit systemError("Failed to create temp directory");
+        return false;
+    }
+    m_workDir = dir;
+
+    if (!writeSource(dir, code, cfg)) {
+        emit systemError("Failed to write source file");
+        cleanup(dir);
+        return false;
+    }
+
+    if (NativeHarness::isEnabled(cfg)) NativeHarness::install(dir);
+
+    if (cfg.compiled) {
+        QString error;
+        if (!compile(dir, cfg, error, overlap)) {
+            emit compilationError(error);
+            cleanup(dir);
+            return false;
+        }
+    }
+    overlap();
+
+    m_artifactHash = ResultCache::artifactHash(dir, cfg);
+    if (!buildLaunchSpec(cfg, dir)) {
+        cleanup(dir);
+        return false;
+    }
+    return true;
+}
+
+bool CodeRunner::buildLaunchSpec(const LanguageConfig &cfg, const QString &dir) {
+    // Untrusted code runs only inside the sandbox once it is asked for
+    if (Sandbox::isRequested()) {
+        QString error;
+        const qint64 start = m_timeline.nowUs();
+        if (!m_sandbox.prepare(dir, error)) {
+            emit systemError(error);
+            return false;
+        }
+        m_timeline.add("sandbox", start, m_timeline.nowUs());
+        m_metrics.sandboxSetupUs = m_sandbox.setupUs();
+    }
+    m_launchSpec = LaunchSpec::build(cfg, dir, m_sandbox.isReady() ? &m_sandbox : nullptr);
+    return true;
+}
+
 void CodeRunner::stop() {
     m_stopRequested = true;
     if (m_currentProcess && m_currentProcess->state() == QProcess::Running) {
-        m_currentProcess->kill();
+        killProcessTree(*m_currentProcess);
     }
+    m_jvmHost->stop();
+    m_nativeHarness->stop();
+}
+
+void CodeRunner::killProcessTree(QProcess &process) {
+    ReapStats stats = ProcessGroup::killTree(process.processId());
+    m_metrics.leakedProcesses += stats.leakedProcesses;
+    m_metrics.leakedCpuMs += stats.leakedCpuMs;
+    process.kill();
+}
+
+void CodeRunner::reapProcessTree(qint64 pgid) {
+    ReapStats stats = ProcessGroup::reap(pgid);
+    m_metrics.leakedProcesses += stats.leakedProcesses;
+    m_metrics.leakedCpuMs += stats.leakedCpuMs;
 }
 
 QString CodeRunner::createWorkDir(const QString &langId) {
@@ -183,15 +398,18 @@ bool CodeRunner::writeSource(const QString &dir, const QString &code, const Lang
     return true;
 }
 
-bool CodeRunner::compile(const QString &dir, const LanguageConfig &cfg, QString &error) {
+bool CodeRunner::compile(const QString &dir, const LanguageConfig &cfg, QString &error,
+                         const std::function<void()> &whileCompiling) {
     QProcess compiler;
     compiler.setWorkingDirectory(dir);
+    ProcessGroup::isolate(compiler);
 
     QString cmd = cfg.expand(cfg.compileCommand, dir);
-    QStringList args = cfg.expandArgs(cfg.compileArgs, dir);
+    QStringList args = NativeHarness::compileArgs(cfg, dir);
 
     qDebug() << "Compiling:" << cmd << args;
 
+    const qint64 start = m_timeline.nowUs();
     compiler.start(cmd, args);
 
     if (!compiler.waitForStarted(5000)) {
@@ -199,15 +417,48 @@ bool CodeRunner::compile(const QString &dir, const LanguageConfig &cfg, QString
         return false;
     }
 
-    if (!compiler.waitForFinished(cfg.compileTimeout)) {
+    // The user is waiting for this one, so it runs even over budget; its
+    // reservation still holds back anything else while it does
+    const qint64 estimate = m_admission.compileEstimateMB(cfg);
+    m_admission.force(estimate);
+
+    whileCompiling();
+
+    // Sampling the compiler tree's resident memory teaches the next estimate
+    QElapsedTimer waited;
+    waited.start();
+    qint64 peakKb = 0;
+    bool finished = false;
+    while (!finished && waited.elapsed() < cfg.compileTimeout) {
+        peakKb = qMax(peakKb, ProcessGroup::residentKb(compiler.processId()));
+        const qint64 left = cfg.compileTimeout - waited.elapsed();
+        finished = compiler.waitForFinished(int(qMin<qint64>(CompileSampleMs, left)));
+    }
+    m_admission.release(estimate);
+    m_timeline.add("compile", start, m_timeline.nowUs());
+
+    if (!finished) {
+        ProcessGroup::killTree(compiler.processId());
         compiler.kill();
         error = "Compilation timed out";
         return false;
     }
 
+    m_admission.recordCompilePeak(cfg, peakKb);
+    m_metrics.compilePeakMB = qMax(m_metrics.compilePeakMB, (peakKb + 1023) / 1024);
+
     if (compiler.exitCode() != 0) {
         error = QString(compiler.readAllStandardError());
         if (error.isEmpty()) error = QString(compiler.readAllStandardOutput());
+        if (NativeHarness::isInstalled(dir) && NativeHarness::isHarnessError(error)) {
+            // The toolchain rejects the harness; tests will use plain exec.
+            // An error in the solution itself is reported as is.
+            qDebug() << "Compiling with the native harness failed, retrying without it";
+            NativeHarness::reject(cfg);
+            NativeHarness::uninstall(dir);
+            error.clear();
+            return compile(dir, cfg, error, whileCompiling);
+        }
         return false;
     }
 
@@ -215,33 +466,388 @@ bool CodeRunner::compile(const QString &dir, const LanguageConfig &cfg, QString
     return true;
 }
 
-void CodeRunner::executeTest(const QString &dir, const LanguageConfig &cfg,
-                             const QJsonObject &test, int index) {
-    // Handle both array and string input formats
-    QString inputStr;
+bool CodeRunner::loadTests(const QString &problemPath, QList<PreparedTest> &prepared) {
+    const qint64 start = m_timeline.nowUs();
 
-    if (test.contains("input")) {
-        QJsonValue inputVal = test["input"];
-        if (inputVal.isArray()) {
-            QJsonArray inputs = inputVal.toArray();
-            for (const auto &arg : inputs) {
-                inputStr += arg.toString() + "\n";
-            }
-        } else if (inputVal.isString()) {
-            inputStr = inputVal.toString();
-            if (!inputStr.endsWith("\n")) {
-                inputStr += "\n";
+    TestCases tests;
+    if (!loadTestCases(problemPath, tests)) return false;
+
+    qDebug() << "Loaded" << tests->size() << "test cases";
+
+    prepared.clear();
+    prepared.reserve(tests->size());
+    bool anySample = false;
+    for (int i = 0; i < tests->size(); ++i) {
+        prepared.append(prepareTest(tests->at(i), i));
+        anySample = anySample || prepared.last().sample;
+    }
+
+    // Unless marked otherwise, the first test is the statement's sample
+    if (!anySample && !prepared.isEmpty()) prepared.first().sample = true;
+
+    m_timeline.add("load tests", start, m_timeline.nowUs());
+    return true;
+}
+
+CodeRunner::PreparedTest CodeRunner::prepareTest(const TestCaseSet::TestCase &test, int index) {
+    // Shares the set's bytes; only a multi-test count below copies them
+    QByteArray input = test.input;
+
+    qDebug() << "Test" << index << "- Input:" << input.size() << "bytes, expected:"
+             << test.expected.size() << "bytes";
+
+    PreparedTest prepared;
+
+    // The bytes are the set's own, shared. A large expected output keys the
+    // result cache by the digest the set already holds, since the verdict
+    // only depends on its tokens, and a wrong answer shows a window around
+    // the first difference instead of the whole text.
+    prepared.expectedOutput.bytes = test.expected;
+    if (test.digestOnly) {
+        prepared.expectedOutput.digestOnly = true;
+        prepared.expectedHash = test.digest.toHex();
+    } else {
+        prepared.expectedHash = ResultCache::hash(test.expected);
+    }
+    prepared.expected = preview(test.expected);
+
+    // Multi-test solutions read a case count first
+    if (m_multiTest != MultiTest::None) {
+        input.prepend("1\n");
+        prepared.caseOffset = 2;
+    }
+
+    prepared.index = index;
+    prepared.input = input;
+    prepared.inputHash = ResultCache::hash(input);
+    prepared.sample = test.sample;
+    prepared.maxTest = test.max || input.size() >= MaxTestInputBytes;
+    prepared.extended = test.extended;
+    return prepared;
+}
+
+bool CodeRunner::isCached(const LanguageConfig &cfg, PreparedTest &prepared) {
+    prepared.cacheKey = ResultCache::makeKey(m_artifactHash, prepared.inputHash,
+                                             prepared.expectedHash, cfg, m_sandbox.isReady());
+    CachedResult cached;
+    if (!m_forceRerun && m_resultCache.lookup(prepared.cacheKey, cached)) {
+        m_metrics.cacheHits++;
+        qDebug() << "Test" << prepared.index << "result (cached):" << cached.status;
+        emit testResultCached(prepared.index);
+        emit testResult(prepared.index, cached.status, cached.output,
+                        cached.expected.isEmpty() ? prepared.expected : cached.expected, cached.timeMs);
+        prepared.reported = true;
+        prepared.accepted = cached.status == "Accepted";
+        if (m_earlyAbort && cached.status != "Accepted") m_aborted = true;
+        return true;
+    }
+    m_metrics.cacheMisses++;
+    return false;
+}
+
+void CodeRunner::reportTest(PreparedTest &prepared, const TestOutcome &outcome) {
+    // A shared-out batch time would pass for this test's own in the cache
+    // and skew the cost ordering built from the stats
+    const bool measured = outcome.cacheable && !outcome.timeShared && !m_stopRequested;
+    if (measured && ResultCache::isCacheable(outcome.status, outcome.output)) {
+        m_resultCache.store(prepared.cacheKey, {outcome.status, outcome.output, outcome.expected, outcome.timeMs});
+    }
+    if (measured) {
+        m_testStats.record(m_problemKey, prepared.statsKey(), outcome.status != "Accepted", outcome.timeMs);
+    }
+    prepared.reported = true;
+    prepared.accepted = outcome.status == "Accepted";
+    if (m_earlyAbort && outcome.status != "Accepted") m_aborted = true;
+
+    qDebug() << "Test" << prepared.index << "result:" << outcome.status << "in" << outcome.timeMs << "ms";
+
+    emit testResult(prepared.index, outcome.status, outcome.output,
+                    outcome.expected.isEmpty() ? prepared.expected : outcome.expected, outcome.timeMs);
+}
+
+void CodeRunner::executeTest(const QString &dir, const LanguageConfig &cfg, PreparedTest &prepared) {
+    if (isCached(cfg, prepared)) return;
+
+    const qint64 start = m_timeline.nowUs();
+    TestOutcome outcome = runTest(dir, cfg, prepared.input, prepared.expectedOutput);
+    m_timeline.add(QString("test %1").arg(prepared.index), start, m_timeline.nowUs());
+
+    reportTest(prepared, outcome);
+}
+
+CodeRunner::TestOutcome CodeRunner::runTest(const QString &dir, const LanguageConfig &cfg,
+                                            const QByteArray &input, const ExpectedOutput &expected) {
+    TestOutcome outcome;
+    bool handled = false;
+    if (m_sandbox.isReady()) {
+        // Every test goes through the sandboxed launch below
+    } else if (cfg.runner == "jvm-host") {
+        handled = runInJvmHost(dir, cfg, input, expected, outcome);
+    } else if (NativeHarness::isEnabled(cfg)) {
+        handled = runInNativeHarness(dir, cfg, input, expected, outcome);
+    }
+    if (!handled) {
+        outcome = runProcess(dir, cfg, input, expected);
+    }
+    return outcome;
+}
+
+QList<int> CodeRunner::runOrder(const QList<PreparedTest> &tests) const {
+    // Samples first, then the core tier before the extended one, each with
+    // its max tests last. Within a tier, the tests most likely to fail per
+    // millisecond they take, so a wrong submission shows early. Tests never
+    // seen before are costed by their input size.
+    QList<int> order;
+    QList<double> score(tests.size());
+    order.reserve(tests.size());
+    for (const PreparedTest &prepared : tests) {
+        if (!prepared.selected) continue;
+        const TestStats::Entry entry = m_testStats.lookup(m_problemKey, prepared.statsKey());
+        const double costMs = entry.runs > 0 ? double(entry.totalMs) / entry.runs
+                                             : 1.0 + prepared.input.size() / 65536.0;
+        order.append(prepared.index);
+        score[prepared.index] = TestStats::failureRate(entry) / (costMs + 1.0);
+    }
+
+    auto tier = [&](int i) {
+        if (tests[i].sample) return 0;
+        return 1 + (tests[i].extended ? 2 : 0) + (tests[i].maxTest ? 1 : 0);
+    };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (tier(a) != tier(b)) return tier(a) < tier(b);
+        return score[a] > score[b];
+    });
+
+    qDebug() << "Test order:" << order;
+    return order;
+}
+
+void CodeRunner::reportSkipped(const QList<PreparedTest> &tests) {
+    for (const PreparedTest &prepared : tests) {
+        if (!prepared.reported) emit testSkipped(prepared.index);
+    }
+}
+
+void CodeRunner::runTestsSequentially(const QString &dir, const LanguageConfig &cfg,
+                                      QList<PreparedTest> &tests) {
+    // A large output is compared on a worker thread while the next test
+    // runs; the comparison touches nothing but its own outcome. Not with
+    // early abort: a failure has to be known before the next test starts.
+    struct Judged {
+        TestOutcome outcome;
+        qint64 startUs = 0;
+        qint64 endUs = 0;
+    };
+    std::future<Judged> judging;
+    int judgingIndex = -1;
+
+    auto collect = [&]() {
+        if (!judging.valid()) return;
+        Judged judged = judging.get();
+        m_timeline.add(QString("compare %1").arg(judgingIndex), judged.startUs, judged.endUs);
+        reportTest(tests[judgingIndex], judged.outcome);
+    };
+
+    const QList<int> order = runOrder(tests);
+
+    m_deferCompare = !m_earlyAbort;
+    for (int k = 0; k < order.size() && !m_stopRequested && !m_aborted; ++k) {
+        const int i = order[k];
+        emit progress(k + 1, order.size());
+        if (isCached(cfg, tests[i])) continue;
+
+        const qint64 start = m_timeline.nowUs();
+        TestOutcome outcome = runTest(dir, cfg, tests[i].input, tests[i].expectedOutput);
+        m_timeline.add(QString("test %1").arg(i), start, m_timeline.nowUs());
+
+        collect();
+        if (!outcome.isPending()) {
+            reportTest(tests[i], outcome);
+            continue;
+        }
+
+        judgingIndex = i;
+        judging = std::async(std::launch::async,
+                             [this, outcome = std::move(outcome), expected = tests[i].expectedOutput]() mutable {
+            Judged judged;
+            judged.startUs = m_timeline.nowUs();
+            comparePending(outcome, expected);
+            judged.endUs = m_timeline.nowUs();
+            judged.outcome = std::move(outcome);
+            return judged;
+        });
+    }
+    collect();
+    m_deferCompare = false;
+}
+
+void CodeRunner::runTestsBatched(const QString &dir, const LanguageConfig &cfg, QList<PreparedTest> &tests) {
+    const int total = std::count_if(tests.begin(), tests.end(),
+                                    [](const PreparedTest &t) { return t.selected; });
+    int completed = 0;
+
+    QList<PreparedTest *> pending;
+    for (PreparedTest &prepared : tests) {
+        if (!prepared.selected) continue;
+        if (isCached(cfg, prepared)) {
+            emit progress(++completed, total);
+        } else {
+            pending.append(&prepared);
+        }
+    }
+    if (pending.isEmpty() || m_aborted) return;
+
+    QList<QByteArrayView> inputs;
+    QList<QByteArray> expected;
+    for (const PreparedTest *prepared : pending) {
+        inputs.append(QByteArrayView(prepared->input).sliced(prepared->caseOffset));
+        expected.append(prepared->expectedOutput.bytes);
+    }
+
+    qDebug() << "Running" << pending.size() << "tests as one batch";
+
+    // The time limit is per case, so the batch gets one for each case it
+    // carries; a batch that still runs out is rerun case by case below
+    LanguageConfig batchCfg = cfg;
+    batchCfg.timeout = int(qMin<qint64>(qint64(cfg.timeout) * pending.size(), INT_MAX));
+
+    const qint64 start = m_timeline.nowUs();
+    m_keepRawOutput = true;
+    ExpectedOutput joined;
+    joined.bytes = expected.join('\n');
+    const TestOutcome batch = runTest(dir, batchCfg, MultiTest::combineInputs(inputs), joined);
+    m_keepRawOutput = false;
+    m_timeline.add("batch", start, m_timeline.nowUs());
+
+    // After a clean exit every case up to the first mismatch is judged from
+    // its slice. The rest run alone, since a wrong case may have thrown the
+    // split off; so does the last case if only trailing output was wrong.
+    // A crash or timeout can't be pinned on one case, so all run alone.
+    int judged = 0;
+    if (batch.status == "Accepted" || batch.status == "Wrong Answer") {
+        const QList<QByteArrayView> slices = MultiTest::split(batch.rawOutput, expected, m_multiTest);
+        const int trusted = batch.status == "Accepted" ? pending.size() : pending.size() - 1;
+
+        while (judged < trusted && OutputNormalizer::equals(slices[judged], expected[judged])) {
+            TestOutcome outcome;
+            outcome.status = "Accepted";
+            outcome.output = preview(slices[judged]);
+            outcome.timeMs = batch.timeMs / pending.size();
+            outcome.timeShared = true;
+            emit progress(++completed, total);
+            reportTest(*pending[judged], outcome);
+            judged++;
+        }
+    }
+    m_metrics.batchedTests += judged;
+
+    for (int i = judged; i < pending.size() && !m_stopRequested && !m_aborted; ++i) {
+        m_metrics.batchReruns++;
+        emit progress(++completed, total);
+        reportTest(*pending[i], runTest(dir, cfg, pending[i]->input, pending[i]->expectedOutput));
+    }
+}
+
+bool CodeRunner::canRunConcurrently(const LanguageConfig &cfg) const {
+    // The warm hosts serve one test at a time
+    return m_launchSpec.isValid() && ProcessReactor::isSupported() &&
+           (m_sandbox.isReady() || (cfg.runner != "jvm-host" && !NativeHarness::isEnabled(cfg)));
+}
+
+void CodeRunner::runTestsConcurrently(const LanguageConfig &cfg, QList<PreparedTest> &tests) {
+    const int limit = qMax(1, QThread::idealThreadCount());
+    const int total = std::count_if(tests.begin(), tests.end(),
+                                    [](const PreparedTest &t) { return t.selected; });
+    const qint64 estimate = AdmissionController::runEstimateMB(cfg);
+
+    QHash<int, qint64> inFlight;   // Index -> start on the timeline
+    int completed = 0;
+
+    // Cached verdicts are reported up front; the rest queue for cores and memory
+    QList<int> queue;
+    for (int index : runOrder(tests)) {
+        if (isCached(cfg, tests[index])) {
+            emit progress(++completed, total);
+        } else {
+            queue.append(index);
+        }
+    }
+    int next = 0;
+
+    // The reactor only hands over finished children; judging waits until
+    // the reactor is back to waiting so comparing one test's output never
+    // delays noticing the others exit
+    std::deque<std::pair<int, ProcessLauncher::Execution>> finished;
+    auto done = [&](int index, ProcessLauncher::Execution &exec) {
+        m_admission.release(estimate);
+        m_timeline.add(QString("test %1").arg(index), inFlight.take(index), m_timeline.nowUs());
+        finished.emplace_back(index, std::move(exec));
+    };
+    auto judgeNext = [&]() {
+        auto [index, exec] = std::move(finished.front());
+        finished.pop_front();
+        emit progress(++completed, total);
+        reportTest(tests[index], judge(exec, tests[index].expectedOutput));
+    };
+
+    while (!m_stopRequested && !m_aborted &&
+           (next < queue.size() || m_reactor.active() > 0 || !finished.empty())) {
+        while (!m_stopRequested && !m_aborted && next < queue.size() && m_reactor.active() < limit &&
+               m_admission.tryAdmit(estimate)) {
+            PreparedTest &prepared = tests[queue[next++]];
+
+            QString error;
+            const qint64 start = m_timeline.nowUs();
+            if (!m_reactor.submit(prepared.index, m_launchSpec, prepared.input, cfg.timeout, error)) {
+                m_admission.release(estimate);
+                TestOutcome outcome;
+                outcome.status = "Runtime Error";
+                outcome.output = error;
+                outcome.cacheable = false;
+                emit progress(++completed, total);
+                reportTest(prepared, outcome);
+                continue;
             }
+            inFlight.insert(prepared.index, start);
+        }
+
+        if (finished.empty()) {
+            if (m_reactor.active() > 0) m_reactor.poll(done);
+        } else {
+            // One verdict, then pick up whatever exited meanwhile without waiting
+            judgeNext();
+            if (m_reactor.active() > 0) m_reactor.poll(done, 0);
         }
     }
 
-    QString expected = test["output"].toString();
+    if (m_aborted) {
+        // Tests still running after the first failure are dropped, not judged
+        m_reactor.killAll([&](int index, ProcessLauncher::Execution &) {
+            m_admission.release(estimate);
+            inFlight.remove(index);
+        });
+        return;
+    }
+    m_reactor.killAll(done);
+    while (!finished.empty()) judgeNext();
+}
 
-    qDebug() << "Test" << index << "- Input:" << inputStr.trimmed() << "Expected:" << expected;
+CodeRunner::TestOutcome CodeRunner::runProcess(const QString &dir, const LanguageConfig &cfg,
+                                               const QByteArray &input, const ExpectedOutput &expected) {
+    if (m_launchSpec.isValid()) {
+        return runSpawned(cfg, input, expected);
+    }
+
+    TestOutcome outcome;
 
     QProcess runner;
     m_currentProcess = &runner;
     runner.setWorkingDirectory(dir);
+    if (m_sandbox.isReady()) {
+        m_sandbox.isolate(runner, dir);
+    } else {
+        ProcessGroup::isolate(runner);
+    }
 
     // Setup environment
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -261,120 +867,273 @@ void CodeRunner::executeTest(const QString &dir, const LanguageConfig &cfg,
     runner.start(cmd, args);
 
     if (!runner.waitForStarted(5000)) {
-        emit testResult(index, "Runtime Error", "Failed to start: " + runner.errorString(), expected, 0);
+        outcome.status = "Runtime Error";
+        outcome.output = "Failed to start: " + runner.errorString();
+        outcome.cacheable = false;
         m_currentProcess = nullptr;
-        return;
+        return outcome;
     }
 
-    if (!inputStr.isEmpty()) {
-        runner.write(inputStr.toUtf8());
+    // The solution leads its own process group; remember it so anything it
+    // forked can still be found after the leader is gone.
+    const qint64 pgid = runner.processId();
+
+    if (!input.isEmpty()) {
+        runner.write(input);
         runner.closeWriteChannel();
     }
 
     bool finished = runner.waitForFinished(cfg.timeout);
-    qint64 timeTaken = timer.elapsed();
-
-    QString status;
-    QString output;
+    outcome.timeMs = timer.elapsed();
 
     if (m_stopRequested) {
-        runner.kill();
-        status = "Stopped";
-        output = "Stopped by user";
+        killProcessTree(runner);
+        outcome.status = "Stopped";
+        outcome.output = "Stopped by user";
     } else if (!finished || runner.state() == QProcess::Running) {
-        runner.kill();
+        killProcessTree(runner);
         runner.waitForFinished(1000);
-        status = "Time Limit Exceeded";
-        output = "";
+        outcome.status = "Time Limit Exceeded";
+        outcome.output = "";
     } else if (runner.exitCode() != 0) {
-        status = "Runtime Error";
-        output = QString(runner.readAllStandardError());
-        if (output.isEmpty()) output = QString(runner.readAllStandardOutput());
+        outcome.status = "Runtime Error";
+        outcome.output = preview(runner.readAllStandardError());
+        if (outcome.output.isEmpty()) outcome.output = preview(runner.readAllStandardOutput());
     } else {
-        QString actual = QString(runner.readAllStandardOutput()).trimmed();
-        // if (actual == expected.trimmed()) {
-        if (OutputNormalizer::equals(actual, expected)) {
-            status = "Accepted";
-        } else {
-            status = "Wrong Answer";
-        }
-        output = actual;
+        judgeOutput(runner.readAllStandardOutput(), expected, outcome);
     }
 
-    qDebug() << "Test" << index << "result:" << status << "in" << timeTaken << "ms";
+    reapProcessTree(pgid);
 
     m_currentProcess = nullptr;
-    emit testResult(index, status, output, expected, timeTaken);
+    return outcome;
 }
 
-void CodeRunner::cleanup(const QString &dir) {
-    if (!dir.isEmpty() && dir.contains("CodeHour_")) {
-        QDir(dir).removeRecursively();
+CodeRunner::TestOutcome CodeRunner::runSpawned(const LanguageConfig &cfg, const QByteArray &input,
+                                               const ExpectedOutput &expected) {
+    ProcessLauncher::Execution exec = ProcessLauncher::run(m_launchSpec, input, cfg.timeout);
+    return judge(exec, expected);
+}
+
+CodeRunner::TestOutcome CodeRunner::judge(ProcessLauncher::Execution &exec, const ExpectedOutput &expected) {
+    TestOutcome outcome;
+    outcome.timeMs = exec.elapsedMs;
+
+    if (!exec.started) {
+        outcome.status = "Runtime Error";
+        outcome.output = exec.error;
+        outcome.cacheable = false;
+        return outcome;
     }
-    m_workDir.clear();
+
+    m_metrics.spawns++;
+    m_metrics.spawnTotalUs += exec.spawnUs;
+    m_metrics.spawnMaxUs = qMax(m_metrics.spawnMaxUs, exec.spawnUs);
+    m_metrics.leakedProcesses += exec.reaped.leakedProcesses;
+    m_metrics.leakedCpuMs += exec.reaped.leakedCpuMs;
+
+    if (m_stopRequested) {
+        outcome.status = "Stopped";
+        outcome.output = "Stopped by user";
+    } else if (exec.timedOut) {
+        outcome.status = "Time Limit Exceeded";
+        outcome.output = "";
+    } else if (exec.outputLimitExceeded) {
+        outcome.status = "Runtime Error";
+        outcome.output = "Output limit exceeded";
+    } else if (exec.crashed || exec.exitCode != 0) {
+        outcome.status = "Runtime Error";
+        outcome.output = preview(exec.standardError.view());
+        if (outcome.output.isEmpty()) outcome.output = preview(exec.standardOutput.view());
+    } else if (m_deferCompare && exec.standardOutput.size() >= DeferCompareBytes) {
+        outcome.pendingOutput = std::move(exec.standardOutput);
+    } else {
+        judgeOutput(exec.standardOutput.view(), expected, outcome);
+    }
+    return outcome;
 }
 
-bool CodeRunner::loadTestCases(const QString &problemPath, QJsonArray &tests) {
-    qDebug() << "Loading test cases from:" << problemPath;
+void CodeRunner::judgeOutput(QByteArrayView actual, const ExpectedOutput &expected, TestOutcome &outcome) {
+    compareOutput(actual, expected, outcome);
+    if (m_keepRawOutput) outcome.rawOutput = actual.toByteArray();
+}
 
-    // Try the path directly first (it might be a full path)
-    if (QFile::exists(problemPath)) {
-        QFile file(problemPath);
-        if (file.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-            file.close();
-            tests = doc.object()["testCases"].toArray();
-            qDebug() << "Loaded" << tests.size() << "test cases from:" << problemPath;
-            return !tests.isEmpty();
+void CodeRunner::judgeOutputFile(const QString &path, const ExpectedOutput &expected, TestOutcome &outcome) {
+    if (m_deferCompare && !m_keepRawOutput && QFileInfo(path).size() >= DeferCompareBytes) {
+        // Moved aside so the next test can write its own output meanwhile
+        const QString pending = path + ".pending" + QString::number(m_deferSerial++);
+        if (QFile::rename(path, pending)) {
+            outcome.pendingPath = pending;
+            return;
         }
     }
 
-    // Try as a problem ID with various base paths
-    QString resolvedPath = getProblemsPath(problemPath);
-    if (!resolvedPath.isEmpty()) {
-        QFile file(resolvedPath);
-        if (file.open(QIODevice::ReadOnly)) {
-            QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-            file.close();
-            tests = doc.object()["testCases"].toArray();
-            qDebug() << "Loaded" << tests.size() << "test cases from:" << resolvedPath;
-            return !tests.isEmpty();
-        }
+    if (!m_keepRawOutput) {
+        compareFile(path, expected, outcome);
+        return;
     }
 
-    qDebug() << "Could not find problem file for:" << problemPath;
-    return false;
+    QFile file(path);
+    judgeOutput(file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray(), expected, outcome);
 }
 
-QString CodeRunner::getProblemsPath(const QString &problemId) const {
-    // Try multiple path patterns
-    QStringList relPaths = {
-        "/data/problems/" + problemId + ".json",
-        "/problems/" + problemId + ".json",
-        "/problems/easy/" + problemId + ".json",
-        "/problems/medium/" + problemId + ".json",
-        "/problems/hard/" + problemId + ".json",
-        problemId + ".json",
-        problemId
-    };
+void CodeRunner::compareOutput(QByteArrayView actual, const ExpectedOutput &expected, TestOutcome &outcome) {
+    // The verdict always comes from the bytes; a digest is only a key
+    if (!expected.digestOnly) {
+        outcome.status = OutputNormalizer::equals(actual, expected.bytes) ? "Accepted" : "Wrong Answer";
+        outcome.output = preview(actual);
+        return;
+    }
 
-    QStringList basePaths = {
-        QDir::currentPath(),
-        QCoreApplication::applicationDirPath(),
-        QCoreApplication::applicationDirPath() + "/..",
-        QCoreApplication::applicationDirPath() + "/../..",
-        QCoreApplication::applicationDirPath() + "/../../.."
-    };
+    // One pass finds the first difference, or that there is none
+    const QByteArray &text = expected.bytes;
+    qsizetype actualPos = 0, expectedPos = 0;
+    const qsizetype token = OutputNormalizer::firstMismatch(actual, text, actualPos, expectedPos);
+    if (token < 0) {
+        outcome.status = "Accepted";
+        outcome.output = preview(actual);
+        return;
+    }
 
-    for (const QString &base : basePaths) {
-        for (const QString &rel : relPaths) {
-            QString full = QDir(base).cleanPath(base + rel);
-            if (QFile::exists(full)) {
-                qDebug() << "Found problem file at:" << full;
-                return full;
-            }
-        }
+    outcome.status = "Wrong Answer";
+    outcome.output = QString("First difference at token %1:\n").arg(token + 1) + window(actual, actualPos);
+    outcome.expected = window(text, expectedPos);
+}
+
+void CodeRunner::compareFile(const QString &path, const ExpectedOutput &expected, TestOutcome &outcome) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        compareOutput(QByteArrayView(), expected, outcome);
+        return;
+    }
+
+    // Compare in place; only the displayed prefix becomes a QString
+    const qint64 size = file.size();
+    if (uchar *data = size > 0 ? file.map(0, size) : nullptr) {
+        compareOutput(QByteArrayView(data, size), expected, outcome);
+        file.unmap(data);
+    } else {
+        compareOutput(file.readAll(), expected, outcome);
+    }
+}
+
+void CodeRunner::comparePending(TestOutcome &outcome, const ExpectedOutput &expected) {
+    if (outcome.pendingOutput.isValid()) {
+        compareOutput(outcome.pendingOutput.view(), expected, outcome);
+        outcome.pendingOutput.close();
+    } else if (!outcome.pendingPath.isEmpty()) {
+        compareFile(outcome.pendingPath, expected, outcome);
+        QFile::remove(outcome.pendingPath);
+        outcome.pendingPath.clear();
+    }
+}
+
+bool CodeRunner::runInJvmHost(const QString &dir, const LanguageConfig &cfg,
+                              const QByteArray &inputData, const ExpectedOutput &expected,
+                              TestOutcome &outcome) {
+    const QString inputPath = dir + "/test_input.txt";
+    const QString outputPath = dir + "/test_output.txt";
+    const QString errorPath = dir + "/test_error.txt";
+
+    QFile input(inputPath);
+    if (!input.open(QIODevice::WriteOnly)) return false;
+    input.write(inputData);
+    input.close();
+
+    qDebug() << "Running in JVM host:" << dir;
+
+    JvmHost::Result result = m_jvmHost->run(dir, inputPath, outputPath, errorPath, cfg.timeout);
+    if (result.kind == JvmHost::Result::Failed) {
+        qDebug() << "JVM host unusable, falling back to exec:" << result.message;
+        return false;
+    }
+
+    outcome.timeMs = result.nanos / 1000000;
+
+    if (m_stopRequested) {
+        outcome.status = "Stopped";
+        outcome.output = "Stopped by user";
+    } else if (result.kind == JvmHost::Result::Timeout) {
+        outcome.status = "Time Limit Exceeded";
+        outcome.timeMs = cfg.timeout;
+    } else if (result.kind == JvmHost::Result::Exception ||
+               (result.kind == JvmHost::Result::Exit && result.exitCode != 0)) {
+        outcome.status = "Runtime Error";
+        outcome.output = readFile(errorPath);
+        if (outcome.output.isEmpty()) outcome.output = result.message;
+        if (outcome.output.isEmpty()) outcome.output = readFile(outputPath);
+    } else {
+        judgeOutputFile(outputPath, expected, outcome);
     }
+    return true;
+}
+
+bool CodeRunner::runInNativeHarness(const QString &dir, const LanguageConfig &cfg,
+                                    const QByteArray &inputData, const ExpectedOutput &expected,
+                                    TestOutcome &outcome) {
+    const QString inputPath = dir + "/test_input.txt";
+    const QString outputPath = dir + "/test_output.txt";
+    const QString errorPath = dir + "/test_error.txt";
+
+    QFile input(inputPath);
+    if (!input.open(QIODevice::WriteOnly)) return false;
+    input.write(inputData);
+    input.close();
+
+    NativeHarness::Result result = m_nativeHarness->run(inputPath, outputPath, errorPath, cfg.timeout);
+    if (result.kind == NativeHarness::Result::Failed) {
+        qDebug() << "Native harness unusable, falling back to exec:" << result.message;
+        return false;
+    }
+
+    m_metrics.leakedProcesses += result.reaped.leakedProcesses;
+    m_metrics.leakedCpuMs += result.reaped.leakedCpuMs;
+    outcome.timeMs = result.wallUs / 1000;
+
+    qDebug() << "Harness test: exit" << result.exitCode << "wall" << result.wallUs << "us, cpu"
+             << result.cpuUs << "us, rss" << result.maxRssKb << "kB";
+
+    if (m_stopRequested) {
+        outcome.status = "Stopped";
+        outcome.output = "Stopped by user";
+    } else if (result.kind == NativeHarness::Result::Timeout) {
+        outcome.status = "Time Limit Exceeded";
+        outcome.timeMs = cfg.timeout;
+    } else if (result.exitCode != 0) {
+        outcome.status = "Runtime Error";
+        outcome.output = readFile(errorPath);
+        if (outcome.output.isEmpty()) outcome.output = readFile(outputPath);
+    } else {
+        judgeOutputFile(outputPath, expected, outcome);
+    }
+    return true;
+}
+
+void CodeRunner::cleanup(const QString &dir) {
+    m_jvmHost->stop();
+    m_nativeHarness->stop();
+    m_launchSpec = LaunchSpec();
+    m_sandbox.release();
+    if (!dir.isEmpty() && dir.contains("CodeHour_")) {
+        QDir(dir).removeRecursively();
+    }
+    m_workDir.clear();
+}
+
+bool CodeRunner::loadTestCases(const QString &problemPath, TestCases &tests) {
+    qDebug() << "Loading test cases from:" << problemPath;
+    m_multiTest = MultiTest::None;
+
+    // A full path or a problem ID; resolved once, then a cache hit
+    const QString resolvedPath = m_problems->resolve(problemPath);
+    if (resolvedPath.isEmpty()) return false;
+
+    // Shared with the problem panel; parsed once while the problem is open
+    const ProblemRepository::Problem problem = m_problems->problem(resolvedPath);
+    if (!problem.isValid()) return false;
 
-    return "";
+    tests = problem.tests;
+    m_multiTest = MultiTest::parse(problem.root["multiTest"]);
+    qDebug() << "Loaded" << tests->size() << "test cases from:" << resolvedPath;
+    return !tests->isEmpty();
 }
@@ -4,47 +4,180 @@
 #include <QObject>
 #include <QProcess>
 #include <QJsonArray>
+#include <functional>
 #include "language_config.h"
+#include "runner_metrics.h"
+#include "result_cache.h"
+#include "speculative_builder.h"
+#include "jvm_host.h"
+#include "native_harness.h"
+#include "process_launcher.h"
+#include "sandbox.h"
+#include "process_reactor.h"
+#include "multi_test.h"
+#include "run_timeline.h"
+#include "test_case_set.h"
+#include "admission_controller.h"
+#include "test_stats.h"
 
 class LanguageRegistry;
+class ProblemRepository;
 
 class CodeRunner : public QObject {
     Q_OBJECT
 
 public:
-    explicit CodeRunner(LanguageRegistry *registry, QObject *parent = nullptr);
+    explicit CodeRunner(LanguageRegistry *registry, ProblemRepository *problems,
+                        QObject *parent = nullptr);
 
-    void runCode(const QString &code, const QString &languageId, const QString &problemId);
+    // Tests marked "tier": "extended" only run when fullSuite is set
+    void runCode(const QString &code, const QString &languageId, const QString &problemId,
+                 bool forceRerun = false, bool fullSuite = false);
     void runSingleTest(const QString &code, const QString &languageId,
-                       int testIndex, const QString &problemId);
+                       int testIndex, const QString &problemId, bool forceRerun = false);
     void stop();
+
+    // Starts a low-priority background compile; a later run with the same
+    // source picks the result up instead of compiling again.
+    void prepareSpeculativeBuild(const QString &code, const QString &languageId);
     bool isRunning() const { return m_running; }
+    const RunnerMetrics &metrics() const { return m_metrics; }
 
 signals:
     void testResult(int testIndex, const QString &status, const QString &output,
                     const QString &expected, qint64 timeMs);
+    // Emitted right before testResult when the verdict came from the cache
+    void testResultCached(int testIndex);
+    // Submit stopped at the first failure before this test got a verdict
+    void testSkipped(int testIndex);
     void compilationError(const QString &error);
+    void buildDiagnostics(const QByteArray &sourceHash, const QList<CompileDiagnostic> &diagnostics);
     void systemError(const QString &error);
     void started();
     void finished();
     void progress(int current, int total);
+    // Emitted by runCode() before finished() unless stopped: how many of the
+    // tests this run selected were accepted. The extended tier a Submit
+    // leaves out is neither passed nor selected.
+    void verdict(int passed, int selected);
 
 private:
     LanguageRegistry *m_registry;
+    ProblemRepository *m_problems;
+    SpeculativeBuilder *m_builder = nullptr;
+    JvmHost *m_jvmHost = nullptr;
+    NativeHarness *m_nativeHarness = nullptr;
     QProcess *m_currentProcess = nullptr;
     QString m_workDir;
     bool m_running = false;
     bool m_stopRequested = false;
+    RunnerMetrics m_metrics;
+    ResultCache m_resultCache;
+    QByteArray m_artifactHash;
+    Sandbox m_sandbox;         // Set up per work dir when SYNTAXFLOW_SANDBOX is set
+    LaunchSpec m_launchSpec;   // Resolved once per run for runSpawned()
+    ProcessReactor m_reactor;  // Runs exec-mode tests concurrently on Linux
+    AdmissionController m_admission;   // Memory budget shared with m_builder
+    TestStats m_testStats;
+    QString m_problemKey;      // Groups m_testStats by problem
+    bool m_earlyAbort = false; // Stop at the first failing test (Submit)
+    bool m_aborted = false;
+    bool m_forceRerun = false;
+    MultiTest::Split m_multiTest = MultiTest::None;  // Set by loadTestCases()
+    bool m_keepRawOutput = false;                    // Fill TestOutcome::rawOutput
+    bool m_deferCompare = false;                     // Leave large outputs for comparePending()
+    int m_deferSerial = 0;
+    RunTimeline m_timeline;
 
+    // whileCompiling runs once while the compiler works (or right away when
+    // there is nothing to compile), so the caller can overlap its own setup
+    bool setupWorkDir(const QString &code, const LanguageConfig &cfg, QString &dir,
+                      const std::function<void()> &whileCompiling);
+    bool buildLaunchSpec(const LanguageConfig &cfg, const QString &dir);
     QString createWorkDir(const QString &langId);
     bool writeSource(const QString &dir, const QString &code, const LanguageConfig &cfg);
-    bool compile(const QString &dir, const LanguageConfig &cfg, QString &error);
-    void executeTest(const QString &dir, const LanguageConfig &cfg,
-                     const QJsonObject &test, int index);
+    bool compile(const QString &dir, const LanguageConfig &cfg, QString &error,
+                 const std::function<void()> &whileCompiling);
+    // What a test's output is judged against: the problem's TestCaseSet's
+    // bytes, shared rather than copied. Large outputs are compared token by
+    // token in one pass that also finds where a wrong answer first differs.
+    struct ExpectedOutput {
+        QByteArray bytes;
+        bool digestOnly = false;   // Shown as a diff window, cached by digest
+    };
+
+    struct TestOutcome {
+        QString status;
+        QString output;
+        QString expected;        // Shown instead of the test's expected output
+        qint64 timeMs = 0;
+        bool cacheable = true;   // False for failures caused by the environment
+        bool timeShared = false; // timeMs is a batch's time split evenly, not measured
+        QByteArray rawOutput;    // Whole stdout, only while m_keepRawOutput
+
+        // A large stdout not compared yet, with m_deferCompare set; status
+        // stays empty until comparePending() fills it in
+        MemoryFile pendingOutput;
+        QString pendingPath;
+        bool isPending() const { return pendingOutput.isValid() || !pendingPath.isEmpty(); }
+    };
+
+    struct PreparedTest {
+        int index = 0;
+        QByteArray input;          // UTF-8, fed to the solution as is
+        qsizetype caseOffset = 0;  // Start of the case itself, after a "1\n" count
+        QString expected;          // For display; cut short for large outputs
+        ExpectedOutput expectedOutput;
+        QByteArray inputHash;
+        QByteArray expectedHash;
+        QByteArray cacheKey;       // Needs the build, so filled in by isCached()
+        bool sample = false;       // Runs first on Submit
+        bool maxTest = false;      // Runs last on Submit
+        bool extended = false;     // Outside the core tier, see CoverageReducer
+        bool selected = true;      // Part of this run's tier
+        bool reported = false;
+        bool accepted = false;
+
+        QByteArray statsKey() const { return inputHash.left(16) + expectedHash.left(16); }
+    };
+
+    // Loads and prepares the problem's tests; needs no build, so it runs
+    // while the compiler does
+    bool loadTests(const QString &problemPath, QList<PreparedTest> &prepared);
+    PreparedTest prepareTest(const TestCaseSet::TestCase &test, int index);
+    // Reports the cached verdict if there is one
+    bool isCached(const LanguageConfig &cfg, PreparedTest &prepared);
+    void reportTest(PreparedTest &prepared, const TestOutcome &outcome);
+    void reportSkipped(const QList<PreparedTest> &tests);
+    // Indices of tests in the order Submit runs them
+    QList<int> runOrder(const QList<PreparedTest> &tests) const;
+    void executeTest(const QString &dir, const LanguageConfig &cfg, PreparedTest &prepared);
+    TestOutcome runTest(const QString &dir, const LanguageConfig &cfg,
+                        const QByteArray &input, const ExpectedOutput &expected);
+    void runTestsSequentially(const QString &dir, const LanguageConfig &cfg,
+                              QList<PreparedTest> &tests);
+    void runTestsBatched(const QString &dir, const LanguageConfig &cfg, QList<PreparedTest> &tests);
+    bool canRunConcurrently(const LanguageConfig &cfg) const;
+    void runTestsConcurrently(const LanguageConfig &cfg, QList<PreparedTest> &tests);
+    TestOutcome judge(ProcessLauncher::Execution &exec, const ExpectedOutput &expected);
+    void judgeOutput(QByteArrayView actual, const ExpectedOutput &expected, TestOutcome &outcome);
+    void judgeOutputFile(const QString &path, const ExpectedOutput &expected, TestOutcome &outcome);
+    // The thread-safe part of judging: comparison and preview only
+    static void compareOutput(QByteArrayView actual, const ExpectedOutput &expected, TestOutcome &outcome);
+    static void compareFile(const QString &path, const ExpectedOutput &expected, TestOutcome &outcome);
+    static void comparePending(TestOutcome &outcome, const ExpectedOutput &expected);
+    TestOutcome runProcess(const QString &dir, const LanguageConfig &cfg,
+                           const QByteArray &input, const ExpectedOutput &expected);
+    TestOutcome runSpawned(const LanguageConfig &cfg, const QByteArray &input, const ExpectedOutput &expected);
+    bool runInJvmHost(const QString &dir, const LanguageConfig &cfg,
+                      const QByteArray &input, const ExpectedOutput &expected, TestOutcome &outcome);
+    bool runInNativeHarness(const QString &dir, const LanguageConfig &cfg,
+                            const QByteArray &input, const ExpectedOutput &expected, TestOutcome &outcome);
     void cleanup(const QString &dir);
+    void killProcessTree(QProcess &process);
+    void reapProcessTree(qint64 pgid);
 
-    bool loadTestCases(const QString &problemId, QJsonArray &tests);
-    QString getProblemsPath(const QString &problemId) const;
+    bool loadTestCases(const QString &problemId, TestCases &tests);
 };
 
 #endif // CODE_RUNNER_H
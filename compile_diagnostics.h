@@ -0,0 +1,64 @@
+#pragma once
+#include <QString>
+#include <QList>
+#include <QRegularExpression>
+#include <QFileInfo>
+
+struct CompileDiagnostic {
+    int line = 0;        // 1-based
+    int column = 0;      // 1-based, 0 when the compiler did not report one
+    QString severity;    // "error" or "warning"
+    QString message;
+};
+
+class CompileDiagnostics {
+public:
+    // Extracts per-line diagnostics for sourceFile from compiler output.
+    // Understands the "file:line[:col]: severity: message" form used by
+    // gcc/clang/go/javac and rustc's "--> file:line:col" locations.
+    static QList<CompileDiagnostic> parse(const QString &output, const QString &sourceFile) {
+        QList<CompileDiagnostic> result;
+        const QString file = QRegularExpression::escape(QFileInfo(sourceFile).fileName());
+
+        static const QString locTail = ":(\\d+)(?::(\\d+))?:?\\s*(?:(fatal error|error|warning)(?:\\[\\w+\\])?:)?\\s*(.*)$";
+        const QRegularExpression gccStyle("^(?:.*[/\\\\])?" + file + locTail);
+        const QRegularExpression rustLoc("^\\s*-->\\s*(?:.*[/\\\\])?" + file + ":(\\d+):(\\d+)");
+        static const QRegularExpression rustHead("^(error|warning)(?:\\[\\w+\\])?:\\s*(.*)$");
+
+        QString pendingSeverity;
+        QString pendingMessage;
+
+        const QStringList lines = output.split('\n');
+        for (const QString &line : lines) {
+            auto head = rustHead.match(line);
+            if (head.hasMatch()) {
+                pendingSeverity = head.captured(1);
+                pendingMessage = head.captured(2);
+                continue;
+            }
+
+            auto loc = rustLoc.match(line);
+            if (loc.hasMatch()) {
+                result.append({loc.captured(1).toInt(), loc.captured(2).toInt(),
+                               pendingSeverity.isEmpty() ? "error" : pendingSeverity,
+                               pendingMessage});
+                pendingSeverity.clear();
+                pendingMessage.clear();
+                continue;
+            }
+
+            auto m = gccStyle.match(line);
+            if (m.hasMatch()) {
+                QString severity = m.captured(3);
+                if (severity.isEmpty()) {
+                    // go reports errors without a severity word; skip gcc's "note:"/"In function" lines
+                    if (m.captured(4).startsWith("note:") || m.captured(4).startsWith("In ")) continue;
+                    severity = "error";
+                }
+                if (severity == "fatal error") severity = "error";
+                result.append({m.captured(1).toInt(), m.captured(2).toInt(), severity, m.captured(4)});
+            }
+        }
+        return result;
+    }
+};
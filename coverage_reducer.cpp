@@ -0,0 +1,261 @@
+#include "coverage_reducer.h"
+#include "jsonutils.h"
+#include "multi_test.h"
+#include "output_normalizer.h"
+#include "test_case_set.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QDebug>
+#include <memory>
+
+bool CoverageReducer::reduce(const QString &problemPath, const QString &solutionPath,
+                             Report &report, QString &error) {
+    QJsonObject problem = loadJsonFile(problemPath);
+    QJsonArray tests = problem["testCases"].toArray();
+    if (tests.isEmpty()) {
+        error = "No test cases in " + problemPath;
+        return false;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        error = "Failed to create a temporary directory";
+        return false;
+    }
+
+    // gcov names its data after the source, so the copy keeps only the suffix
+    const QString buildDir = tempDir.filePath("build");
+    const QString source = "solution." + QFileInfo(solutionPath).suffix();
+    QDir().mkpath(buildDir);
+    if (!QFile::copy(solutionPath, buildDir + "/" + source)) {
+        error = "Failed to read " + solutionPath;
+        return false;
+    }
+    if (!compile(buildDir, source, error)) return false;
+
+    const bool multiTest = MultiTest::parse(problem["multiTest"]) != MultiTest::None;
+    QList<QByteArray> inputs;
+    QList<qsizetype> cost;
+    QList<int> samples;
+    for (int i = 0; i < tests.size(); ++i) {
+        const QJsonObject test = tests[i].toObject();
+        QByteArray input = TestCaseSet::input(test);
+        if (multiTest) input.prepend("1\n");
+        inputs.append(input);
+        cost.append(input.size());
+        if (test["sample"].toBool()) samples.append(i);
+    }
+    if (samples.isEmpty()) samples.append(0);
+
+    // Each run writes its counters under its own prefix, so the tests can
+    // run side by side without merging their coverage. Stdin and stdout are
+    // files: nothing here services pipes while it waits on one process, so
+    // a large input or output would stall the others behind a full pipe.
+    const int depth = QDir::cleanPath(buildDir).count('/');
+    auto dataDir = [&](int i) { return tempDir.filePath(QString("cov%1").arg(i)); };
+    auto inputFile = [&](int i) { return tempDir.filePath(QString("in%1").arg(i)); };
+    auto outputFile = [&](int i) { return tempDir.filePath(QString("out%1").arg(i)); };
+    for (int i = 0; i < tests.size(); ++i) {
+        QFile file(inputFile(i));
+        if (!file.open(QIODevice::WriteOnly) || file.write(inputs[i]) != inputs[i].size()) {
+            error = "Failed to write " + file.fileName();
+            return false;
+        }
+    }
+
+    const int limit = qMax(1, QThread::idealThreadCount());
+    for (int first = 0; first < tests.size(); first += limit) {
+        const int last = qMin<int>(first + limit, tests.size());
+
+        std::vector<std::unique_ptr<QProcess>> running;
+        for (int i = first; i < last; ++i) {
+            auto process = std::make_unique<QProcess>();
+            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+            env.insert("GCOV_PREFIX", dataDir(i));
+            env.insert("GCOV_PREFIX_STRIP", QString::number(depth));
+            process->setProcessEnvironment(env);
+            process->setWorkingDirectory(buildDir);
+            process->setStandardInputFile(inputFile(i));
+            process->setStandardOutputFile(outputFile(i));
+            process->setStandardErrorFile(QProcess::nullDevice());
+            process->start(buildDir + "/solution", QStringList());
+            running.push_back(std::move(process));
+        }
+
+        for (int i = first; i < last; ++i) {
+            QProcess &process = *running[i - first];
+            const QString expected = tests[i].toObject()["output"].toString();
+            if (!process.waitForFinished(TestTimeoutMs)) {
+                process.kill();
+                process.waitForFinished();
+                report.failing.append(i);
+                continue;
+            }
+            QFile output(outputFile(i));
+            if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 ||
+                !output.open(QIODevice::ReadOnly) ||
+                !OutputNormalizer::equals(output.readAll(), expected.toUtf8())) {
+                report.failing.append(i);
+            }
+        }
+    }
+
+    QList<Coverage> coverage;
+    Coverage total;
+    for (int i = 0; i < tests.size(); ++i) {
+        Coverage covered;
+        if (!readCoverage(dataDir(i), buildDir, source, covered, error)) return false;
+        total.unite(covered);
+        coverage.append(covered);
+    }
+
+    // A test the reference fails is suspect; keep it in sight
+    QList<int> seed = samples;
+    for (int i : report.failing) {
+        if (!seed.contains(i)) seed.append(i);
+    }
+
+    const QList<int> core = cover(coverage, seed, cost);
+    for (int i = 0; i < tests.size(); ++i) {
+        QJsonObject test = tests[i].toObject();
+        test["tier"] = core.contains(i) ? "core" : "extended";
+        tests[i] = test;
+    }
+    problem["testCases"] = tests;
+
+    QSaveFile file(problemPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "Failed to write " + problemPath;
+        return false;
+    }
+    file.write(QJsonDocument(problem).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        error = "Failed to write " + problemPath;
+        return false;
+    }
+
+    report.tests = tests.size();
+    report.core = core.size();
+    for (qint64 item : total) {
+        if (item & 0xffff) report.branches++;
+        else report.lines++;
+    }
+    return true;
+}
+
+bool CoverageReducer::compile(const QString &buildDir, const QString &source, QString &error) {
+    const QString compiler = source.endsWith(".c") ? "gcc" : "g++";
+    const QList<QStringList> steps = {
+        {"-O0", "--coverage", "-c", source, "-o", "solution.o"},
+        {"--coverage", "solution.o", "-o", "solution"},
+    };
+
+    for (const QStringList &args : steps) {
+        QProcess process;
+        process.setWorkingDirectory(buildDir);
+        process.setProcessChannelMode(QProcess::MergedChannels);
+        qDebug() << "Running:" << compiler << args;
+        process.start(compiler, args);
+        if (!process.waitForFinished(60000) || process.exitCode() != 0) {
+            error = "Failed to build the reference solution:\n" +
+                    QString::fromUtf8(process.readAll()) + process.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CoverageReducer::readCoverage(const QString &dataDir, const QString &buildDir,
+                                   const QString &source, Coverage &coverage, QString &error) {
+    // A run that died before exiting normally leaves no counters
+    if (!QFile::exists(dataDir + "/solution.gcda")) return true;
+
+    QFile::copy(buildDir + "/solution.gcno", dataDir + "/solution.gcno");
+
+    QProcess gcov;
+    gcov.setWorkingDirectory(dataDir);
+    gcov.start("gcov", {"--json-format", "--stdout", "--branch-probabilities",
+                        "--object-directory", dataDir, buildDir + "/" + source});
+    if (!gcov.waitForFinished(60000) || gcov.exitCode() != 0) {
+        error = "gcov failed (GCC 10 or newer is needed): " +
+                QString::fromUtf8(gcov.readAllStandardError()) + gcov.errorString();
+        return false;
+    }
+
+    const QJsonObject report = QJsonDocument::fromJson(gcov.readAllStandardOutput()).object();
+    for (const QJsonValue &file : report["files"].toArray()) {
+        // Only the solution counts, not the library headers it pulls in
+        if (QFileInfo(file["file"].toString()).fileName() != source) continue;
+
+        for (const QJsonValue &line : file["lines"].toArray()) {
+            if (line["count"].toInteger() == 0) continue;
+
+            const qint64 key = line["line_number"].toInteger() << 16;
+            coverage.insert(key);
+
+            const QJsonArray branches = line["branches"].toArray();
+            for (int k = 0; k < branches.size() && k < 0xffff; ++k) {
+                // Exception edges depend on the library, not the test
+                if (branches[k]["throw"].toBool()) continue;
+                if (branches[k]["count"].toInteger() > 0) coverage.insert(key | (k + 1));
+            }
+        }
+    }
+    return true;
+}
+
+QList<int> CoverageReducer::cover(const QList<Coverage> &coverage, const QList<int> &seed,
+                                  const QList<qsizetype> &cost) {
+    QList<int> chosen = seed;
+    Coverage covered;
+    for (int i : seed) covered.unite(coverage[i]);
+
+    // Greedy: take the test adding the most, the cheaper one on ties
+    for (;;) {
+        int best = -1;
+        qsizetype bestGain = 0;
+        for (int i = 0; i < coverage.size(); ++i) {
+            if (chosen.contains(i)) continue;
+            qsizetype gain = 0;
+            for (qint64 item : coverage[i]) {
+                if (!covered.contains(item)) gain++;
+            }
+            if (gain > bestGain || (gain == bestGain && gain > 0 && cost[i] < cost[best])) {
+                best = i;
+                bestGain = gain;
+            }
+        }
+        if (best < 0) break;
+        chosen.append(best);
+        covered.unite(coverage[best]);
+    }
+
+    // Prune: a test picked early may be covered by later picks together
+    QHash<qint64, int> hits;
+    for (int i : chosen) {
+        for (qint64 item : coverage[i]) hits[item]++;
+    }
+    for (int c = chosen.size() - 1; c >= seed.size(); --c) {
+        const Coverage &items = coverage[chosen[c]];
+        bool redundant = true;
+        for (qint64 item : items) {
+            if (hits.value(item) < 2) {
+                redundant = false;
+                break;
+            }
+        }
+        if (!redundant) continue;
+        for (qint64 item : items) hits[item]--;
+        chosen.removeAt(c);
+    }
+    return chosen;
+}
@@ -0,0 +1,46 @@
+#ifndef COVERAGE_REDUCER_H
+#define COVERAGE_REDUCER_H
+
+#include <QList>
+#include <QSet>
+#include <QString>
+
+// Authoring tool that splits a problem's tests into tiers. The reference
+// solution (C or C++) is built with gcov instrumentation and run on every
+// test; a smallest subset reaching the same line and branch coverage as
+// the whole suite is marked "tier": "core" in the problem JSON and the rest
+// "extended". Submit runs the core tier, the full suite runs on demand.
+//
+// Samples always stay in the core tier. The subset is found greedily
+// (most new coverage first, cheaper input on ties) and then pruned of
+// tests the others already cover, which is not guaranteed minimal but
+// close in practice.
+//
+// Run as: SyntaxFlow --reduce-tests <problem.json> <reference.cpp>
+class CoverageReducer {
+public:
+    struct Report {
+        int tests = 0;
+        int core = 0;
+        int lines = 0;            // Covered by the whole suite
+        int branches = 0;
+        QList<int> failing;       // Tests the reference solution does not pass
+    };
+
+    static bool reduce(const QString &problemPath, const QString &solutionPath,
+                       Report &report, QString &error);
+
+private:
+    // Line n is (n << 16), its k-th branch taken is (n << 16) | (k + 1)
+    using Coverage = QSet<qint64>;
+
+    static constexpr int TestTimeoutMs = 10000;
+
+    static bool compile(const QString &buildDir, const QString &source, QString &error);
+    static bool readCoverage(const QString &dataDir, const QString &buildDir,
+                             const QString &source, Coverage &coverage, QString &error);
+    static QList<int> cover(const QList<Coverage> &coverage, const QList<int> &seed,
+                            const QList<qsizetype> &cost);
+};
+
+#endif // COVERAGE_REDUCER_H
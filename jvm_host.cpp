@@ -0,0 +1,411 @@
+#include "jvm_host.h"
+#include "process_group.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+
+namespace {
+
+constexpr int StartupTimeoutMs = 10000;
+
+// Line protocol over a loopback connection the host makes back to us, so
+// the JVM's own stdin/stdout (fds 0 and 1, both the null device) never
+// carry it:
+//   <- HELLO <token>
+//   <- READY
+//   -> RUN <classDir>\t<input>\t<output>\t<error>
+//   <- OK <nanos> | EXIT <status|?> <nanos> | EXC <nanos> <message> | FAIL <message>
+// "EXIT ?" comes from the shutdown hook when System.exit() could not be
+// trapped (no SecurityManager on JDK 18+); the status is then the host's.
+// A reply starting with '~' means the test left threads running; the host
+// is replaced before the next test.
+const char *HostSource = R"JAVA(
+import java.io.*;
+import java.lang.reflect.*;
+import java.net.*;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.*;
+
+public class SyntaxFlowHost {
+    static final class ExitTrap extends SecurityException {
+        final int status;
+        ExitTrap(int status) { super("exit " + status); this.status = status; }
+    }
+
+    static PrintStream proto;
+    static volatile PrintStream testOut;
+    static volatile long startedAt;
+
+    static final Map<String, Boolean> rawFdUse = new HashMap<>();
+
+    public static void main(String[] args) throws Exception {
+        Socket control = new Socket(InetAddress.getLoopbackAddress(), Integer.parseInt(args[0]));
+        control.setTcpNoDelay(true);
+        proto = new PrintStream(control.getOutputStream(), true, "UTF-8");
+        BufferedReader commands = new BufferedReader(
+            new InputStreamReader(control.getInputStream(), StandardCharsets.UTF_8));
+        proto.println("HELLO " + args[1]);
+
+        boolean trapsExit = installExitTrap();
+        Runtime.getRuntime().addShutdownHook(new Thread(() -> {
+            PrintStream out = testOut;
+            if (out != null) {
+                out.flush();
+                proto.println("EXIT ? " + (System.nanoTime() - startedAt));
+            }
+        }));
+
+        proto.println("READY " + (trapsExit ? "trap" : "hook"));
+
+        String line;
+        while ((line = commands.readLine()) != null) {
+            if (!line.startsWith("RUN ")) continue;
+            String[] parts = line.substring(4).split("\t");
+            if (parts.length != 4) {
+                proto.println("FAIL bad command");
+                continue;
+            }
+            Set<Thread> before = new HashSet<>(Thread.getAllStackTraces().keySet());
+            String reply = runOne(parts[0], parts[1], parts[2], parts[3]).replace('\n', ' ');
+            proto.println((leftThreads(before) ? "~" : "") + reply);
+        }
+    }
+
+    // Non-daemon threads the test started and did not finish; given a
+    // moment to end on their own
+    static boolean leftThreads(Set<Thread> before) {
+        long deadline = System.nanoTime() + 100_000_000L;
+        for (Thread t : Thread.getAllStackTraces().keySet()) {
+            if (before.contains(t) || t.isDaemon() || t == Thread.currentThread()) continue;
+            try {
+                t.join(Math.max(1, (deadline - System.nanoTime()) / 1_000_000));
+            } catch (InterruptedException e) {
+                return true;
+            }
+            if (t.isAlive()) return true;
+        }
+        return false;
+    }
+
+    // Solutions that open FileDescriptor.in/out themselves (the usual fast
+    // I/O) bypass System.setIn/setOut, so they can't share the host
+    static boolean usesRawFds(File dir) throws IOException {
+        File[] classes = dir.listFiles((d, name) -> name.endsWith(".class"));
+        if (classes == null) return false;
+        long stamp = 0;
+        for (File f : classes) stamp = Math.max(stamp, f.lastModified());
+        String key = dir.getPath() + "@" + stamp;
+        Boolean known = rawFdUse.get(key);
+        if (known != null) return known;
+
+        byte[] needle = "java/io/FileDescriptor".getBytes(StandardCharsets.US_ASCII);
+        boolean uses = false;
+        for (File f : classes) {
+            byte[] bytes = Files.readAllBytes(f.toPath());
+            outer:
+            for (int i = 0; i + needle.length <= bytes.length; i++) {
+                for (int j = 0; j < needle.length; j++) {
+                    if (bytes[i + j] != needle[j]) continue outer;
+                }
+                uses = true;
+                break;
+            }
+            if (uses) break;
+        }
+        rawFdUse.put(key, uses);
+        return uses;
+    }
+
+    @SuppressWarnings("removal")
+    static boolean installExitTrap() {
+        try {
+            System.setSecurityManager(new SecurityManager() {
+                @Override public void checkExit(int status) {
+                    if (testOut != null) throw new ExitTrap(status);
+                }
+                @Override public void checkPermission(java.security.Permission p) {}
+                @Override public void checkPermission(java.security.Permission p, Object ctx) {}
+            });
+            return true;
+        } catch (Throwable t) {
+            return false;
+        }
+    }
+
+    static String runOne(String classDir, String in, String out, String err) {
+        try {
+            if (usesRawFds(new File(classDir))) return "FAIL solution uses FileDescriptor streams";
+        } catch (IOException e) {
+            return "FAIL " + e;
+        }
+
+        InputStream oldIn = System.in;
+        PrintStream oldOut = System.out;
+        PrintStream oldErr = System.err;
+        ClassLoader parent = ClassLoader.getSystemClassLoader().getParent();
+
+        try (InputStream tin = new BufferedInputStream(new FileInputStream(in), 1 << 16);
+             PrintStream tout = new PrintStream(new BufferedOutputStream(new FileOutputStream(out), 1 << 16), false);
+             PrintStream terr = new PrintStream(new FileOutputStream(err), true);
+             URLClassLoader loader = new URLClassLoader(new URL[] { new File(classDir).toURI().toURL() }, parent)) {
+
+            Method main = loader.loadClass("Main").getMethod("main", String[].class);
+            System.setIn(tin);
+            System.setOut(tout);
+            System.setErr(terr);
+
+            testOut = tout;
+            startedAt = System.nanoTime();
+            try {
+                main.invoke(null, (Object) new String[0]);
+                return "OK " + (System.nanoTime() - startedAt);
+            } catch (InvocationTargetException e) {
+                long nanos = System.nanoTime() - startedAt;
+                Throwable cause = e.getCause();
+                if (cause instanceof ExitTrap) return "EXIT " + ((ExitTrap) cause).status + " " + nanos;
+                cause.printStackTrace(terr);
+                return "EXC " + nanos + " " + cause;
+            } finally {
+                testOut = null;
+                tout.flush();
+            }
+        } catch (Throwable t) {
+            return "FAIL " + t;
+        } finally {
+            System.setIn(oldIn);
+            System.setOut(oldOut);
+            System.setErr(oldErr);
+        }
+    }
+}
+)JAVA";
+
+} // namespace
+
+JvmHost::JvmHost(QObject *parent) : QObject(parent) {}
+
+JvmHost::~JvmHost() {
+    stop();
+}
+
+bool JvmHost::ensureCompiled(const LanguageConfig &cfg) {
+    const QByteArray source(HostSource);
+    const QString version = QCryptographicHash::hash(source, QCryptographicHash::Sha256).toHex().left(12);
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+                        + "/jvm-host/" + version;
+
+    if (QFile::exists(dir + "/SyntaxFlowHost.class")) {
+        m_hostDir = dir;
+        return true;
+    }
+
+    QDir().mkpath(dir);
+    QFile file(dir + "/SyntaxFlowHost.java");
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(source);
+    file.close();
+
+    QProcess javac;
+    javac.setWorkingDirectory(dir);
+    javac.start(cfg.expand(cfg.compileCommand, dir),
+                {"-encoding", "UTF-8", "-nowarn", "SyntaxFlowHost.java"});
+
+    if (!javac.waitForFinished(cfg.compileTimeout) || javac.exitCode() != 0 ||
+        !QFile::exists(dir + "/SyntaxFlowHost.class")) {
+        qWarning() << "Failed to build JVM host:" << javac.readAllStandardError();
+        QDir(dir).removeRecursively();
+        return false;
+    }
+
+    qDebug() << "Built JVM host in" << dir;
+    m_hostDir = dir;
+    return true;
+}
+
+bool JvmHost::start(const LanguageConfig &cfg) {
+    stop();
+    m_cfg = cfg;
+    m_unavailable = false;
+    m_rawFdDir.clear();
+    return launch();
+}
+
+bool JvmHost::launch() {
+    const LanguageConfig &cfg = m_cfg;
+    if (!ensureCompiled(cfg)) {
+        m_unavailable = true;
+        return false;
+    }
+
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(QHostAddress::LocalHost, 0)) {
+        qWarning() << "JVM host: cannot listen on loopback:" << m_server->errorString();
+        stop();
+        m_unavailable = true;
+        return false;
+    }
+    m_token = QByteArray::number(QRandomGenerator::system()->generate64(), 16);
+
+    m_process = new QProcess(this);
+    m_process->setWorkingDirectory(m_hostDir);
+    m_process->setStandardInputFile(QProcess::nullDevice());
+    m_process->setStandardOutputFile(QProcess::nullDevice());
+    m_process->setStandardErrorFile(QProcess::nullDevice());
+    ProcessGroup::isolate(*m_process);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (auto it = cfg.environment.begin(); it != cfg.environment.end(); ++it) {
+        env.insert(it.key(), cfg.expand(it.value(), m_hostDir));
+    }
+    m_process->setProcessEnvironment(env);
+
+    m_process->start(cfg.expand(cfg.runCommand, m_hostDir),
+                     {"-XX:+UseSerialGC", "-cp", m_hostDir, "SyntaxFlowHost",
+                      QString::number(m_server->serverPort()), QString::fromLatin1(m_token)});
+
+    if (!m_process->waitForStarted(5000)) {
+        qWarning() << "Failed to start JVM host:" << m_process->errorString();
+        stop();
+        m_unavailable = true;
+        return false;
+    }
+    return true;
+}
+
+void JvmHost::stop() {
+    delete m_control;
+    m_control = nullptr;
+    delete m_server;
+    m_server = nullptr;
+    m_ready = false;
+    if (!m_process) return;
+
+    if (m_process->state() != QProcess::NotRunning) {
+        ProcessGroup::killTree(m_process->processId());
+        m_process->kill();
+        m_process->waitForFinished(1000);
+    }
+    delete m_process;
+    m_process = nullptr;
+}
+
+bool JvmHost::isRunning() const {
+    return m_process && m_process->state() != QProcess::NotRunning;
+}
+
+bool JvmHost::readLine(QByteArray &line, int msecs) {
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!m_control->canReadLine()) {
+        const int remaining = msecs - int(timer.elapsed());
+        if (remaining <= 0 || m_control->state() != QAbstractSocket::ConnectedState) return false;
+        m_control->waitForReadyRead(remaining);
+    }
+
+    line = m_control->readLine().trimmed();
+    return true;
+}
+
+bool JvmHost::waitReady(int msecs) {
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_server->waitForNewConnection(msecs)) return false;
+    m_control = m_server->nextPendingConnection();
+    m_server->close();   // Nobody else gets to connect
+
+    QByteArray line;
+    const int left = qMax(0, msecs - int(timer.elapsed()));
+    if (!readLine(line, left) || line != "HELLO " + m_token) return false;
+    if (!readLine(line, qMax(0, msecs - int(timer.elapsed()))) || !line.startsWith("READY")) return false;
+
+    qDebug() << "JVM host ready:" << line;
+    m_ready = true;
+    return true;
+}
+
+JvmHost::Result JvmHost::run(const QString &classDir, const QString &inputPath,
+                             const QString &outputPath, const QString &errorPath, int timeoutMs) {
+    Result result;
+
+    if (classDir == m_rawFdDir) {
+        result.message = "Solution uses FileDescriptor streams";
+        return result;
+    }
+
+    // The previous test may have taken the host down (System.exit, timeout)
+    if (m_unavailable || (!isRunning() && !launch())) {
+        result.message = "JVM host not available";
+        return result;
+    }
+    if (!m_ready && !waitReady(StartupTimeoutMs)) {
+        stop();
+        m_unavailable = true;
+        result.message = "JVM host did not start";
+        return result;
+    }
+
+    const QString args = classDir + '\t' + inputPath + '\t' + outputPath + '\t' + errorPath;
+    m_control->write("RUN " + args.toUtf8() + "\n");
+    m_control->waitForBytesWritten(1000);
+
+    QByteArray line;
+    if (!readLine(line, timeoutMs)) {
+        // A dropped connection means the host is on its way down
+        if (m_control->state() == QAbstractSocket::ConnectedState && isRunning()) {
+            result.kind = Result::Timeout;
+        } else {
+            // Crashed without reporting anything
+            m_process->waitForFinished(1000);
+            result.kind = Result::Exit;
+            result.exitCode = m_process->exitCode();
+        }
+        stop();
+        return result;
+    }
+
+    // Threads the test left behind would run into the next one
+    const bool recycle = line.startsWith('~');
+    if (recycle) line.remove(0, 1);
+
+    const QList<QByteArray> parts = line.split(' ');
+    const QByteArray tag = parts.value(0);
+
+    if (tag == "OK") {
+        result.kind = Result::Ok;
+        result.nanos = parts.value(1).toLongLong();
+    } else if (tag == "EXIT") {
+        result.kind = Result::Exit;
+        result.nanos = parts.value(2).toLongLong();
+        if (parts.value(1) == "?") {
+            // Untrapped System.exit: the host is going down with that status
+            m_process->waitForFinished(1000);
+            result.exitCode = m_process->exitCode();
+            stop();
+        } else {
+            result.exitCode = parts.value(1).toInt();
+        }
+    } else if (tag == "EXC") {
+        result.kind = Result::Exception;
+        result.nanos = parts.value(1).toLongLong();
+        result.message = QString::fromUtf8(line.mid(line.indexOf(' ', 4) + 1));
+    } else {
+        result.kind = Result::Failed;
+        result.message = QString::fromUtf8(line);
+        if (line.contains("FileDescriptor")) m_rawFdDir = classDir;
+    }
+
+    if (recycle && isRunning()) {
+        qDebug() << "JVM host: test left threads running, restarting the host";
+        stop();
+    }
+    return result;
+}
@@ -0,0 +1,69 @@
+#ifndef JVM_HOST_H
+#define JVM_HOST_H
+
+#include <QObject>
+#include <QProcess>
+#include "language_config.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+// A JVM that stays alive for all tests of a run. Each test loads the
+// solution's classes through a fresh classloader, gets System.in/out/err
+// redirected to files and only the invocation of Main.main() is timed, so
+// tests no longer pay JVM startup and JDK class loading every time.
+//
+// The host is a tiny Java program (embedded in jvm_host.cpp) compiled once
+// per installation with the language's compiler and cached in app data.
+// It takes commands over a loopback connection, never its stdin/stdout,
+// which solutions may open directly. A test that leaves threads running
+// gets the host replaced before the next one; a solution that opens
+// FileDescriptor.in/out is reported as Failed and runs as its own process.
+class JvmHost : public QObject {
+    Q_OBJECT
+
+public:
+    struct Result {
+        enum Kind {
+            Ok,         // main() returned
+            Exit,       // System.exit(exitCode)
+            Exception,  // main() threw; stack trace is in the error file
+            Timeout,    // Host killed after timeoutMs
+            Failed      // Host unusable; caller should fall back to exec
+        };
+        Kind kind = Failed;
+        int exitCode = 0;
+        qint64 nanos = 0;
+        QString message;
+    };
+
+    explicit JvmHost(QObject *parent = nullptr);
+    ~JvmHost();
+
+    // Launches the host without waiting for it; JVM startup overlaps with
+    // whatever the caller does next (typically javac).
+    bool start(const LanguageConfig &cfg);
+    void stop();
+    bool isRunning() const;
+
+    Result run(const QString &classDir, const QString &inputPath,
+               const QString &outputPath, const QString &errorPath, int timeoutMs);
+
+private:
+    bool launch();
+    bool ensureCompiled(const LanguageConfig &cfg);
+    bool waitReady(int msecs);
+    bool readLine(QByteArray &line, int msecs);
+
+    QProcess *m_process = nullptr;
+    QTcpServer *m_server = nullptr;
+    QTcpSocket *m_control = nullptr;   // The host's connection, once it made it
+    QByteArray m_token;                // Proves the connection is the host's
+    QString m_rawFdDir;                // Class dir known to bypass System.in/out
+    LanguageConfig m_cfg;
+    QString m_hostDir;
+    bool m_ready = false;
+    bool m_unavailable = false;   // Don't retry a host that failed to build or launch
+};
+
+#endif // JVM_HOST_H
@@ -32,6 +32,7 @@ LanguageConfig LanguageConfig::fromJson(const QJsonObject &json, const QString &
 
     config.timeout = json.value("timeout").toInt(2000);
     config.memoryLimitMB = json.value("memoryLimit").toInt(256);
+    config.runner = json.value("runner").toString("exec");
 
     QJsonObject envObj = json.value("environment").toObject();
     for (auto it = envObj.begin(); it != envObj.end(); ++it) {
@@ -63,6 +64,7 @@ QJsonObject LanguageConfig::toJson() const {
     if (!runArgs.isEmpty()) json["runArgs"] = QJsonArray::fromStringList(runArgs);
     json["timeout"] = timeout;
     json["memoryLimit"] = memoryLimitMB;
+    if (runner != "exec") json["runner"] = runner;
 
     if (!codeTemplate.isEmpty()) json["template"] = codeTemplate;
     json["commentPrefix"] = commentPrefix;
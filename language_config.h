@@ -27,6 +27,8 @@ struct LanguageConfig {
     QStringList runArgs;
     int timeout = 2000;
     int memoryLimitMB = 256;
+    QString runner = "exec";   // "exec": one process per test, "jvm-host": warm JVM,
+                               // "native-harness": fork per test from a warm C/C++ image
 
     // Environment
     QMap<QString, QString> environment;
@@ -67,6 +67,7 @@ QJsonObject LanguageRegistry::builtinC() {
                             "-lm"
                         }},
         {"runCommand", "{workdir}/{output}"},
+        {"runner", "native-harness"},
         {"timeout", 2000},
         {"template", "#include <stdio.h>\n\nint main() {\n    \n    return 0;\n}\n"}
     };
@@ -81,6 +82,7 @@ QJsonObject LanguageRegistry::builtinCpp() {
         {"compileCommand", "g++"},
         {"compileArgs", QJsonArray{"-std=c++17", "-O2", "-Wall", "-o", "{output}", "{source}"}},
         {"runCommand", "{workdir}/{output}"},
+        {"runner", "native-harness"},
         {"timeout", 2000},
         {"template", "#include <bits/stdc++.h>\nusing namespace std;\n\nint main() {\n    \n    return 0;\n}\n"}
     };
@@ -113,6 +115,7 @@ QJsonObject LanguageRegistry::builtinJava() {
         {"compileArgs", QJsonArray{"{source}"}},
         {"runCommand", "java"},
         {"runArgs", QJsonArray{"-cp", "{workdir}", "Main"}},
+        {"runner", "jvm-host"},
         {"timeout", 3000},
         {"template", "import java.util.*;\n\npublic class Main {\n    public static void main(String[] args) {\n        \n    }\n}\n"}
     };
@@ -1,9 +1,214 @@
 #include "mainwindow.h"
+#include "coverage_reducer.h"
+#include "process_launcher.h"
+#include "problem_importer.h"
+#include "problem_pack.h"
+#include "sandbox.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+
+// Authoring: SyntaxFlow --reduce-tests <problem.json> <reference.cpp>
+static int reduceTests(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+
+    CoverageReducer::Report report;
+    QString error;
+    if (!CoverageReducer::reduce(QString::fromLocal8Bit(argv[2]), QString::fromLocal8Bit(argv[3]),
+                                 report, error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 1;
+    }
+
+    out << "Core tier: " << report.core << " of " << report.tests << " tests, covering "
+        << report.lines << " lines and " << report.branches << " branches" << Qt::endl;
+    for (int i : report.failing) {
+        out << "Warning: the reference solution fails test " << i + 1 << Qt::endl;
+    }
+    return report.failing.isEmpty() ? 0 : 2;
+}
+
+// Distribution: SyntaxFlow --pack <dir with problems.json and problems/> <out.sfpack>
+static int packProblems(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QString error;
+    if (!ProblemPack::write(QString::fromLocal8Bit(argv[2]), QString::fromLocal8Bit(argv[3]), error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 1;
+    }
+
+    ProblemPack pack;
+    if (!pack.open(QString::fromLocal8Bit(argv[3]))) return 1;
+    QTextStream(stdout) << "Packed " << pack.size() << " files into " << argv[3] << Qt::endl;
+    return 0;
+}
+
+// Authoring: SyntaxFlow --import <archive dir> <dir with problems.json> [<out.sfpack>]
+static int importProblems(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    const QString rootDir = QString::fromLocal8Bit(argv[3]);
+
+    QElapsedTimer timer;
+    timer.start();
+    ProblemImporter::Report report;
+    QString error;
+    if (!ProblemImporter::import(QString::fromLocal8Bit(argv[2]), rootDir, report, error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 1;
+    }
+
+    for (const QString &rejected : report.rejected) {
+        out << "Rejected " << rejected << Qt::endl;
+    }
+    out << "Imported " << report.imported << " of " << report.found << " problems ("
+        << report.duplicates << " duplicates, " << report.rejected.size() << " rejected) in "
+        << timer.elapsed() << " ms" << Qt::endl;
+
+    if (argc == 5) {
+        if (!ProblemPack::write(rootDir, QString::fromLocal8Bit(argv[4]), error)) {
+            QTextStream(stderr) << error << Qt::endl;
+            return 1;
+        }
+        out << "Packed into " << argv[4] << Qt::endl;
+    }
+    return report.rejected.isEmpty() ? 0 : 2;
+}
+
+static void printLatency(QTextStream &out, const char *name, QList<qint64> us)
+{
+    std::sort(us.begin(), us.end());
+    qint64 total = 0;
+    for (qint64 v : us) total += v;
+    out << qSetFieldWidth(22) << Qt::left << name << qSetFieldWidth(0)
+        << "mean " << total / us.size() << " us, p50 " << us[us.size() / 2]
+        << " us, p99 " << us[us.size() * 99 / 100] << " us" << Qt::endl;
+}
+
+// Benchmark: SyntaxFlow --bench-launcher [runs]
+// Spawns `true` through ProcessLauncher and through QProcess
+static int benchLauncher(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    const int runs = argc > 2 ? qMax(1, QByteArray(argv[2]).toInt()) : 500;
+
+    QTemporaryDir dir;
+    LanguageConfig cfg;
+    cfg.compiled = false;
+    cfg.runCommand = "true";
+    const LaunchSpec spec = LaunchSpec::build(cfg, dir.path());
+    if (!dir.isValid() || !spec.isValid()) {
+        QTextStream(stderr) << "Fast launcher unavailable" << Qt::endl;
+        return 1;
+    }
+
+    QList<qint64> spawnUs;
+    QList<qint64> launcherUs;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const ProcessLauncher::Execution exec = ProcessLauncher::run(spec, QByteArray(), 5000);
+        if (!exec.started) {
+            QTextStream(stderr) << exec.error << Qt::endl;
+            return 1;
+        }
+        launcherUs.append(timer.nsecsElapsed() / 1000);
+        spawnUs.append(exec.spawnUs);
+    }
+
+    QList<qint64> processUs;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        QProcess process;
+        process.setWorkingDirectory(dir.path());
+        process.start(QString::fromLocal8Bit(spec.program()), {});
+        process.closeWriteChannel();
+        if (!process.waitForFinished(5000)) {
+            QTextStream(stderr) << "QProcess run failed: " << process.errorString() << Qt::endl;
+            return 1;
+        }
+        processUs.append(timer.nsecsElapsed() / 1000);
+    }
+
+    out << runs << " runs of " << spec.program() << Qt::endl;
+    printLatency(out, "launcher spawn", spawnUs);
+    printLatency(out, "launcher until exit", launcherUs);
+    printLatency(out, "QProcess until exit", processUs);
+    return 0;
+}
+
+// Benchmark: SyntaxFlow --bench-sandbox [runs]
+// Spawns `true` through ProcessLauncher with and without the sandbox
+static int benchSandbox(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    const int runs = argc > 2 ? qMax(1, QByteArray(argv[2]).toInt()) : 500;
+
+    QTemporaryDir dir;
+    LanguageConfig cfg;
+    cfg.compiled = false;
+    cfg.runCommand = "true";
+
+    Sandbox sandbox;
+    QString error;
+    if (!dir.isValid() || !sandbox.prepare(dir.path(), error)) {
+        QTextStream(stderr) << "Sandbox unavailable: " << error << Qt::endl;
+        return 1;
+    }
+    out << "sandbox setup: " << sandbox.setupUs() << " us (once per run)" << Qt::endl;
+
+    for (const Sandbox *mode : {static_cast<const Sandbox *>(nullptr), &sandbox}) {
+        const LaunchSpec spec = LaunchSpec::build(cfg, dir.path(), mode);
+        QList<qint64> spawnUs;
+        QList<qint64> totalUs;
+        for (int i = 0; i < runs; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            const ProcessLauncher::Execution exec = ProcessLauncher::run(spec, QByteArray(), 5000);
+            if (!exec.started) {
+                QTextStream(stderr) << exec.error << Qt::endl;
+                return 1;
+            }
+            totalUs.append(timer.nsecsElapsed() / 1000);
+            spawnUs.append(exec.spawnUs);
+        }
+        out << (mode ? "sandboxed" : "unsandboxed") << ", " << runs << " runs" << Qt::endl;
+        printLatency(out, "  spawn until exec", spawnUs);
+        printLatency(out, "  spawn until exit", totalUs);
+    }
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc == 4 && qstrcmp(argv[1], "--reduce-tests") == 0) {
+        return reduceTests(argc, argv);
+    }
+    if (argc == 4 && qstrcmp(argv[1], "--pack") == 0) {
+        return packProblems(argc, argv);
+    }
+    if ((argc == 4 || argc == 5) && qstrcmp(argv[1], "--import") == 0) {
+        return importProblems(argc, argv);
+    }
+    if (argc >= 2 && qstrcmp(argv[1], "--bench-launcher") == 0) {
+        return benchLauncher(argc, argv);
+    }
+    if (argc >= 2 && qstrcmp(argv[1], "--bench-sandbox") == 0) {
+        return benchSandbox(argc, argv);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -6,6 +6,7 @@
 #include "hoversidebar.h"
 #include "TreeSitterHighlighter.h"
 #include "backend.h"
+#include "problem_repository.h"
 
 #include <QStackedLayout>
 #include <QVBoxLayout>
@@ -98,7 +99,14 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
     resize(1400, 900);
-    const QString appDir = QCoreApplication::applicationDirPath();
+    // Problem authors can point this at the source tree to see their edits
+    // live instead of the copy the build makes next to the binary
+    const QString problemsRoot = qEnvironmentVariable("SYNTAXFLOW_PROBLEMS");
+    const QString appDir = problemsRoot.isEmpty() ? QCoreApplication::applicationDirPath()
+                                                  : problemsRoot;
+    // A shipped problems.sfpack takes the place of the loose files
+    const QString packPath = QDir(appDir).filePath("problems.sfpack");
+    const bool usePack = QFile::exists(packPath);
         ProblemsBasePath = QDir(appDir).filePath("problems/");
         ProblemsJsonPath = QDir(appDir).filePath("problems.json");
 
@@ -106,6 +114,13 @@ MainWindow::MainWindow(QWidget *parent)
         qDebug() << ProblemsBasePath << "-- [the ProblemsBasePath]";
         qDebug() << ProblemsJsonPath << "-- [the ProblemsJsonPath]";
         progressManager = new ProgressManager();
+        problemRepository = new ProblemRepository(this);
+        if (usePack && problemRepository->openPack(packPath)) {
+            ProblemsBasePath = problemRepository->problemsDir();
+            ProblemsJsonPath = packPath + "/problems.json";
+        } else {
+            problemRepository->open(ProblemsJsonPath, ProblemsBasePath);
+        }
 
         SolutionsBasePath = QStandardPaths::writableLocation(
                                 QStandardPaths::AppDataLocation) + "/solutions/";
@@ -121,7 +136,12 @@ MainWindow::MainWindow(QWidget *parent)
     populateLanguages();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    // The repository is an earlier child and is destroyed first; the
+    // statement prefetcher still reads through it
+    problemPanel->stopPrefetching();
+}
 
 // ═══════════════════════════════════════════════════════════════════════════
 // Backend Setup
@@ -129,17 +149,32 @@ MainWindow::~MainWindow() = default;
 
 void MainWindow::setupBackend()
 {
-    m_backend = new Backend(this);
+    m_backend = new Backend(problemRepository, this);
 
     // Connect backend signals
     connect(m_backend, &Backend::testResult,
             this, &MainWindow::onTestResult);
+    connect(m_backend, &Backend::testResultCached, this, [this](int testIndex) {
+        testCasePanel->setTestCached(testIndex);
+    });
+    connect(m_backend, &Backend::testSkipped, this, [this](int testIndex) {
+        testCasePanel->resetTestResult(testIndex);
+    });
     connect(m_backend, &Backend::compilationError,
             this, &MainWindow::onCompilationError);
+    connect(m_backend, &Backend::buildDiagnostics, this,
+            [this](const QByteArray &sourceHash, const QList<CompileDiagnostic> &diagnostics) {
+        // The build finished after more typing; its lines no longer match
+        const QString langId = languageCombo->currentData().toString();
+        if (sourceHash != m_backend->sourceHash(codeEditor->toPlainText(), langId)) return;
+        codeEditor->setDiagnostics(diagnostics);
+    });
     connect(m_backend, &Backend::systemError,
             this, &MainWindow::onSystemError);
     connect(m_backend, &Backend::executionStarted,
             this, &MainWindow::onExecutionStarted);
+    connect(m_backend, &Backend::executionVerdict,
+            this, &MainWindow::onExecutionVerdict);
     connect(m_backend, &Backend::executionFinished,
             this, &MainWindow::onExecutionFinished);
     connect(m_backend, &Backend::languagesChanged,
@@ -173,8 +208,8 @@ void MainWindow::setupBrowserPage()
     auto *layout = new QVBoxLayout(browserPage);
     layout->setContentsMargins(GlobalMargin, 0, 0, 0);
 
-    browser = new ProblemBrowser(progressManager,this);
-    browser->loadFromJson(ProblemsJsonPath);
+    browser = new ProblemBrowser(progressManager, problemRepository, this);
+    browser->loadCatalog();
 
     layout->addWidget(browser);
     stack->addWidget(browserPage);
@@ -213,7 +248,7 @@ void MainWindow::setupEditorPage()
     rightVerticalSplitter->setStyleSheet(splitterStyle);
 
     // ─── Problem Panel ───
-    problemPanel = new ProblemPanel(this);
+    problemPanel = new ProblemPanel(problemRepository, this);
     problemPanel->setMinimumWidth(300);
     problemPanel->setMaximumWidth(600);
 
@@ -341,6 +376,8 @@ void MainWindow::setupEditorPage()
     submitButton = new QPushButton("Submit");
     submitButton->setObjectName("submitBtn");
     submitButton->setCursor(Qt::PointingHandCursor);
+    submitButton->setToolTip("Run all tests (Ctrl+Shift+Enter)\n"
+                             "Re-run ignoring cached results (Ctrl+Shift+R)");
     submitButton->setStyleSheet(R"(
         #submitBtn {
             background: #238636;
@@ -412,6 +449,10 @@ void MainWindow::setupConnections()
     connect(problemPanel, &ProblemPanel::testCasesAvailable,
             testCasePanel, &TestCasePanel::loadTestCases);
 
+    // Problem files edited on disk
+    connect(problemRepository, &ProblemRepository::problemChanged,
+            this, &MainWindow::onProblemChanged);
+
     // Toolbar buttons
     connect(runButton, &QPushButton::clicked,
             this, &MainWindow::onRunCurrentTest);
@@ -439,6 +480,9 @@ void MainWindow::setupConnections()
             );
     });
 
+    // Compile in the background once typing pauses
+    connect(codeEditor, &CodeEditor::typingIdle,
+            this, &MainWindow::requestSpeculativeBuild);
 
 }
 
@@ -459,6 +503,16 @@ void MainWindow::setupShortcuts()
     connect(runAllTests, &QShortcut::activated,
             this, &MainWindow::onRunAllTests);
 
+    // Run the extended tier as well: Ctrl+Shift+F
+    auto *runFullSuite = new QShortcut(QKeySequence("Ctrl+Shift+F"), this);
+    connect(runFullSuite, &QShortcut::activated,
+            this, &MainWindow::onRunFullSuite);
+
+    // Re-run all tests ignoring cached results: Ctrl+Shift+R
+    auto *forceRerun = new QShortcut(QKeySequence("Ctrl+Shift+R"), this);
+    connect(forceRerun, &QShortcut::activated,
+            this, &MainWindow::onForceRerunAllTests);
+
     // Stop execution: Escape
     auto *stopExec = new QShortcut(QKeySequence("Escape"), this);
     connect(stopExec, &QShortcut::activated,
@@ -536,6 +590,8 @@ void MainWindow::onLanguageChanged(int)
     }
 
     codeEditor->blockSignals(false);
+    codeEditor->clearDiagnostics();
+    requestSpeculativeBuild();
 }
 
 void MainWindow::updateLanguageIndicator()
@@ -649,10 +705,15 @@ void MainWindow::onNavigateToEditor(const QString &path)
     }
 
     codeEditor->blockSignals(false);
+    codeEditor->clearDiagnostics();
+    requestSpeculativeBuild();
 
     // Focus the code editor
     codeEditor->setFocus();
 
+    const QString next = browser->pathAfter(path);
+    if (!next.isEmpty()) problemPanel->prefetch(ProblemsBasePath + next);
+
 }
 
 void MainWindow::onNavigateToBrowser()
@@ -666,6 +727,24 @@ void MainWindow::onNavigateToBrowser()
     stack->setCurrentWidget(browserPage);
 }
 
+void MainWindow::onProblemChanged(const QString &filePath)
+{
+    if (m_currentProblemPath.isEmpty() ||
+        QFileInfo(filePath).absoluteFilePath() != QFileInfo(m_currentProblemPath).absoluteFilePath())
+        return;
+
+    // Reloading swaps the test cases under a running Submit; wait for it
+    if (m_backend->isRunning()) {
+        m_problemReloadPending = true;
+        return;
+    }
+
+    qDebug() << ">>> Problem file changed, reloading:" << filePath;
+    if (problemPanel->loadFromFile(m_currentProblemPath)) {
+        testCasePanel->clearAllResults();
+    }
+}
+
 // ═══════════════════════════════════════════════════════════════════════════
 // Code Execution
 // ═══════════════════════════════════════════════════════════════════════════
@@ -707,6 +786,21 @@ void MainWindow::onRunCurrentTest()
 }
 
 void MainWindow::onRunAllTests()
+{
+    runAllTests(false);
+}
+
+void MainWindow::onForceRerunAllTests()
+{
+    runAllTests(true);
+}
+
+void MainWindow::onRunFullSuite()
+{
+    runAllTests(false, true);
+}
+
+void MainWindow::runAllTests(bool forceRerun, bool fullSuite)
 {
     QString langId = languageCombo->currentData().toString();
 
@@ -738,10 +832,21 @@ void MainWindow::onRunAllTests()
     m_backend->runCode(
         codeEditor->toPlainText(),
         langId,
-        m_currentProblemPath  // Pass full path
+        m_currentProblemPath,  // Pass full path
+        forceRerun,
+        fullSuite
         );
 }
 
+void MainWindow::requestSpeculativeBuild()
+{
+    if (m_currentProblemPath.isEmpty() || m_backend->isRunning())
+        return;
+
+    m_backend->prepareBuild(codeEditor->toPlainText(),
+                            languageCombo->currentData().toString());
+}
+
 void MainWindow::onStopExecution()
 {
     if (m_backend->isRunning()) {
@@ -780,6 +885,9 @@ void MainWindow::onCompilationError(const QString &error)
 {
     qDebug() << "Compilation error:" << error;
 
+    LanguageConfig cfg = m_backend->getLanguageConfig(languageCombo->currentData().toString());
+    codeEditor->setDiagnostics(CompileDiagnostics::parse(error, cfg.sourceFile));
+
     // Show error in all running tests
     int count = testCasePanel->getTestCaseCount();
     for (int i = 0; i < count; ++i) {
@@ -807,35 +915,39 @@ void MainWindow::onExecutionStarted()
     setExecutionState(true);
 }
 
-void MainWindow::onExecutionFinished()
+void MainWindow::onExecutionVerdict(int passed, int selected)
 {
-    qDebug() << "Execution finished";
-    setExecutionState(false);
+    if (!m_runningAllTests) return;
 
-    if (m_runningAllTests) {
-
-        int passed = 0;
-        int total = testCasePanel->getTestCaseCount();
+    // Counted by the runner over the tests it selected: a Submit runs the
+    // core tier only, so the panel's total would never be reached
+    qDebug() << "Results:" << passed << "/" << selected << "passed";
 
-        for (int i = 0; i < total; ++i) {
-            if (testCasePanel->isTestPassed(i)) {
-                passed++;
-            }
-        }
+    // ✅ Mark solved only if ALL passed
+    if (selected > 0 && passed == selected) {
+        qDebug() << "All test cases passed. Marking as solved.";
 
-        qDebug() << "Results:" << passed << "/" << total << "passed";
+        progressManager->markSolved(m_currentProblemId, true);
 
-        // ✅ Mark solved only if ALL passed
-        if (total > 0 && passed == total) {
-            qDebug() << "All test cases passed. Marking as solved.";
+        qDebug() << "Current ID:" << extractProblemId(m_currentProblemId);
+    }
+}
 
-            progressManager->markSolved(m_currentProblemId, true);
+void MainWindow::onExecutionFinished()
+{
+    qDebug() << "Execution finished";
+    setExecutionState(false);
 
-            qDebug() << "Current ID:" << extractProblemId(m_currentProblemId);
-        }
+    if (m_runningAllTests) {
+        progressManager->recordAttempt(m_currentProblemId);
     }
 
     m_runningAllTests = false;
+
+    if (m_problemReloadPending) {
+        m_problemReloadPending = false;
+        onProblemChanged(m_currentProblemPath);
+    }
 }
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -19,6 +19,7 @@ class HoverSidebar;
 class TreeSitterHighlighter;
 class QTextDocument;
 class Backend;
+class ProblemRepository;
 
 class MainWindow : public QMainWindow
 {
@@ -43,10 +44,13 @@ private slots:
     // Navigation
     void onNavigateToEditor(const QString &path);
     void onNavigateToBrowser();
+    void onProblemChanged(const QString &filePath);
 
     // Code Execution
     void onRunCurrentTest();
     void onRunAllTests();
+    void onForceRerunAllTests();
+    void onRunFullSuite();
     void onStopExecution();
 
     // Backend Results
@@ -55,6 +59,7 @@ private slots:
     void onCompilationError(const QString &error);
     void onSystemError(const QString &error);
     void onExecutionStarted();
+    void onExecutionVerdict(int passed, int selected);
     void onExecutionFinished();
 
     // Language
@@ -75,6 +80,10 @@ private:
     CodeEditor* createEditor();
     TreeSitterHighlighter* createHighlighter(QTextDocument *document);
 
+    // Execution
+    void runAllTests(bool forceRerun, bool fullSuite = false);
+    void requestSpeculativeBuild();
+
     // Update UI state
     void setExecutionState(bool running);
     void updateLanguageIndicator();
@@ -89,6 +98,7 @@ private:
     Backend *m_backend = nullptr;
     QString m_currentProblemPath;  // Full path to the problem JSON file
     bool m_runningAllTests = false;
+    bool m_problemReloadPending = false;   // Open problem edited during a run
 
     // ─── Layout ───
     QStackedLayout *stack = nullptr;
@@ -117,6 +127,7 @@ private:
     HoverSidebar *sidebar = nullptr;
 
     ProgressManager *progressManager;
+    ProblemRepository *problemRepository;
     QString m_currentProblemId;
 };
 
@@ -0,0 +1,123 @@
+#include "memory_file.h"
+
+#include <QDir>
+#include <QFile>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryFile::~MemoryFile() {
+    close();
+}
+
+MemoryFile::MemoryFile(MemoryFile &&other) noexcept
+    : m_fd(other.m_fd), m_map(other.m_map), m_mapSize(other.m_mapSize) {
+    other.m_fd = -1;
+    other.m_map = nullptr;
+    other.m_mapSize = 0;
+}
+
+MemoryFile &MemoryFile::operator=(MemoryFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        m_map = other.m_map;
+        m_mapSize = other.m_mapSize;
+        other.m_fd = -1;
+        other.m_map = nullptr;
+        other.m_mapSize = 0;
+    }
+    return *this;
+}
+
+#ifdef Q_OS_UNIX
+
+bool MemoryFile::create(const char *name) {
+    close();
+
+#ifdef Q_OS_LINUX
+    m_fd = ::memfd_create(name, MFD_CLOEXEC);
+#else
+    Q_UNUSED(name);
+#endif
+    if (m_fd < 0) {
+        QByteArray path = QFile::encodeName(QDir::tempPath() + "/syntaxflow-XXXXXX");
+        m_fd = ::mkostemp(path.data(), O_CLOEXEC);
+        if (m_fd >= 0) ::unlink(path.constData());
+    }
+    return m_fd >= 0;
+}
+
+bool MemoryFile::write(const QByteArray &data) {
+    if (m_fd < 0) return false;
+    if (::ftruncate(m_fd, 0) < 0) return false;
+
+    const char *p = data.constData();
+    qint64 left = data.size();
+    while (left > 0) {
+        const ssize_t n = ::pwrite(m_fd, p, size_t(left), data.size() - left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        left -= n;
+    }
+    return ::lseek(m_fd, 0, SEEK_SET) == 0;
+}
+
+qint64 MemoryFile::size() const {
+    struct stat st;
+    if (m_fd < 0 || ::fstat(m_fd, &st) < 0) return 0;
+    return st.st_size;
+}
+
+QByteArrayView MemoryFile::view() const {
+    if (m_map) return QByteArrayView(static_cast<const char *>(m_map), m_mapSize);
+
+    const qint64 bytes = size();
+    if (bytes <= 0) return QByteArrayView();
+
+    void *map = ::mmap(nullptr, size_t(bytes), PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) return QByteArrayView();
+
+    m_map = map;
+    m_mapSize = bytes;
+    return QByteArrayView(static_cast<const char *>(m_map), m_mapSize);
+}
+
+void MemoryFile::close() {
+    if (m_map) ::munmap(m_map, size_t(m_mapSize));
+    if (m_fd >= 0) ::close(m_fd);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_fd = -1;
+}
+
+#else
+
+bool MemoryFile::create(const char *) {
+    return false;
+}
+
+bool MemoryFile::write(const QByteArray &) {
+    return false;
+}
+
+qint64 MemoryFile::size() const {
+    return 0;
+}
+
+QByteArrayView MemoryFile::view() const {
+    return QByteArrayView();
+}
+
+void MemoryFile::close() {}
+
+#endif
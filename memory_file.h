@@ -0,0 +1,40 @@
+#ifndef MEMORY_FILE_H
+#define MEMORY_FILE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+// An anonymous in-memory file (memfd on Linux, an unlinked temp file on
+// other Unix systems) used as a test's stdin, stdout or stderr. The child
+// reads and writes it directly, and the runner looks at the result through
+// a read-only mapping, so test data never passes through a pipe or gets
+// copied into a QString just to be compared.
+class MemoryFile {
+public:
+    MemoryFile() = default;
+    ~MemoryFile();
+    MemoryFile(MemoryFile &&other) noexcept;
+    MemoryFile &operator=(MemoryFile &&other) noexcept;
+    MemoryFile(const MemoryFile &) = delete;
+    MemoryFile &operator=(const MemoryFile &) = delete;
+
+    bool create(const char *name);
+    bool isValid() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+
+    // Replaces the contents and rewinds, ready to be a child's stdin
+    bool write(const QByteArray &data);
+
+    // Maps the current contents; valid until close() or destruction
+    QByteArrayView view() const;
+    qint64 size() const;
+
+    void close();
+
+private:
+    int m_fd = -1;
+    mutable void *m_map = nullptr;
+    mutable qint64 m_mapSize = 0;
+};
+
+#endif // MEMORY_FILE_H
@@ -0,0 +1,95 @@
+#pragma once
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+
+// Support for problems whose solutions read a leading test count ("T test
+// cases"). Such problems opt in with "multiTest" in their JSON:
+//   "multiTest": true                  split the output by token counts
+//   "multiTest": { "split": "lines" }  split by line counts instead
+// All cases then run as one process and the output is cut back into one
+// slice per case, sized after that case's expected output. A case run on
+// its own gets a count of 1 so the same solution reads it.
+class MultiTest {
+public:
+    enum Split { None, Tokens, Lines };
+
+    static Split parse(const QJsonValue &value) {
+        if (value.isBool()) return value.toBool() ? Tokens : None;
+        if (value.isObject()) {
+            return value.toObject().value("split").toString() == "lines" ? Lines : Tokens;
+        }
+        return None;
+    }
+
+    // "T\n" followed by every case's input (each already ends in '\n')
+    static QByteArray combineInputs(const QList<QByteArrayView> &inputs) {
+        qsizetype size = 16;
+        for (QByteArrayView input : inputs) size += input.size();
+
+        QByteArray combined;
+        combined.reserve(size);
+        combined += QByteArray::number(inputs.size()) + '\n';
+        for (QByteArrayView input : inputs) combined += input;
+        return combined;
+    }
+
+    // Cuts actual into one slice per expected output. Slices point into
+    // actual; cases past the end of the output get an empty slice.
+    static QList<QByteArrayView> split(QByteArrayView actual, const QList<QByteArray> &expected,
+                                       Split mode) {
+        QList<QByteArrayView> slices;
+        slices.reserve(expected.size());
+        qsizetype pos = 0;
+
+        for (const QByteArray &exp : expected) {
+            const qsizetype want = mode == Lines ? countLines(exp) : countTokens(exp);
+            const qsizetype start = mode == Lines ? pos : skipSpace(actual, pos);
+            qsizetype end = start;
+
+            for (qsizetype taken = 0; taken < want && end < actual.size(); ++taken) {
+                if (mode == Lines) {
+                    const qsizetype nl = actual.indexOf('\n', end);
+                    end = nl < 0 ? actual.size() : nl + 1;
+                } else {
+                    end = skipSpace(actual, end);
+                    while (end < actual.size() && !isSpace(actual[end])) ++end;
+                }
+            }
+
+            slices.append(actual.sliced(start, end - start));
+            pos = end;
+        }
+        return slices;
+    }
+
+private:
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    static qsizetype skipSpace(QByteArrayView bytes, qsizetype pos) {
+        while (pos < bytes.size() && isSpace(bytes[pos])) ++pos;
+        return pos;
+    }
+
+    static qsizetype countTokens(QByteArrayView bytes) {
+        qsizetype count = 0;
+        qsizetype pos = skipSpace(bytes, 0);
+        while (pos < bytes.size()) {
+            ++count;
+            while (pos < bytes.size() && !isSpace(bytes[pos])) ++pos;
+            pos = skipSpace(bytes, pos);
+        }
+        return count;
+    }
+
+    static qsizetype countLines(QByteArrayView bytes) {
+        qsizetype end = bytes.size();
+        while (end > 0 && isSpace(bytes[end - 1])) --end;
+        if (end == 0) return 0;
+        return bytes.first(end).count('\n') + 1;
+    }
+};
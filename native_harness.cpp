@@ -0,0 +1,361 @@
+#include "native_harness.h"
+
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+constexpr int StartupTimeoutMs = 5000;
+constexpr int ReportTimeoutMs = 2000;
+
+// Line protocol on the harness's original stdin/stdout:
+//   <- READY
+//   -> RUN <input>\t<output>\t<error>
+//   <- PID <pid>
+//   <- DONE <exit status> <wall us> <cpu us> <max rss kB> | FAIL <message>
+// The constructor runs at priority 101, ahead of the solution's own static
+// initialisers, so those run per test in the forked child. Only raw fds are
+// used before forking so no stdio buffer is shared with the children.
+const char *HarnessSource = R"HARNESS(
+/* SyntaxFlow native batch harness, linked in by the runner.
+ * Inert unless the process is started with SYNTAXFLOW_HARNESS=1. */
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static int sf_harness_read_line(int fd, char *buf, size_t cap)
+{
+    size_t len = 0;
+    while (len + 1 < cap) {
+        char c;
+        ssize_t n = read(fd, &c, 1);
+        if (n <= 0) return -1;
+        if (c == '\n') break;
+        buf[len++] = c;
+    }
+    buf[len] = '\0';
+    return (int)len;
+}
+
+static void sf_harness_write(int fd, const char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0) {
+        ssize_t n = write(fd, text, len);
+        if (n <= 0) return;
+        text += n;
+        len -= (size_t)n;
+    }
+}
+
+static int sf_harness_redirect(const char *path, int target, int flags)
+{
+    int fd = open(path, flags, 0644);
+    if (fd < 0) return -1;
+    if (fd != target) {
+        dup2(fd, target);
+        close(fd);
+    }
+    return 0;
+}
+
+static long long sf_harness_usec(struct timeval tv)
+{
+    return (long long)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+__attribute__((constructor(101)))
+static void sf_harness_main(void)
+{
+    const char *mode = getenv("SYNTAXFLOW_HARNESS");
+    if (mode == NULL || strcmp(mode, "1") != 0) return;
+    unsetenv("SYNTAXFLOW_HARNESS");
+
+    int ctl_in = dup(0);
+    int ctl_out = dup(1);
+    char line[16384];
+    char reply[256];
+
+    signal(SIGPIPE, SIG_IGN);
+    sf_harness_write(ctl_out, "READY\n");
+
+    while (sf_harness_read_line(ctl_in, line, sizeof line) >= 0) {
+        if (strncmp(line, "RUN ", 4) != 0) continue;
+
+        char *input = line + 4;
+        char *output = strchr(input, '\t');
+        char *error = output ? strchr(output + 1, '\t') : NULL;
+        if (output == NULL || error == NULL) {
+            sf_harness_write(ctl_out, "FAIL bad command\n");
+            continue;
+        }
+        *output++ = '\0';
+        *error++ = '\0';
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            sf_harness_write(ctl_out, "FAIL fork\n");
+            continue;
+        }
+        if (pid == 0) {
+            /* Test process: own group so the runner can kill its whole tree */
+            setpgid(0, 0);
+            signal(SIGPIPE, SIG_DFL);
+            close(ctl_in);
+            close(ctl_out);
+            if (sf_harness_redirect(input, 0, O_RDONLY) < 0 ||
+                sf_harness_redirect(output, 1, O_WRONLY | O_CREAT | O_TRUNC) < 0 ||
+                sf_harness_redirect(error, 2, O_WRONLY | O_CREAT | O_TRUNC) < 0) {
+                _exit(127);
+            }
+            return; /* continue into static initialisers and main() */
+        }
+        setpgid(pid, pid);
+
+        snprintf(reply, sizeof reply, "PID %d\n", (int)pid);
+        sf_harness_write(ctl_out, reply);
+
+        int status = 0;
+        struct rusage usage;
+        memset(&usage, 0, sizeof usage);
+        while (wait4(pid, &status, 0, &usage) < 0) {
+            /* EINTR only */
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        int code = WIFEXITED(status) ? WEXITSTATUS(status)
+                 : WIFSIGNALED(status) ? 128 + WTERMSIG(status) : 1;
+        long long wall = (long long)(end.tv_sec - start.tv_sec) * 1000000LL
+                       + (end.tv_nsec - start.tv_nsec) / 1000;
+        long long cpu = sf_harness_usec(usage.ru_utime) + sf_harness_usec(usage.ru_stime);
+
+        snprintf(reply, sizeof reply, "DONE %d %lld %lld %ld\n", code, wall, cpu, (long)usage.ru_maxrss);
+        sf_harness_write(ctl_out, reply);
+    }
+
+    _exit(0);
+}
+
+#endif
+)HARNESS";
+
+} // namespace
+
+const char *NativeHarness::SourceName = "sf_harness.c";
+
+QMutex NativeHarness::s_rejectedMutex;
+QSet<QString> NativeHarness::s_rejected;
+
+bool NativeHarness::isEnabled(const LanguageConfig &cfg) {
+#ifdef Q_OS_UNIX
+    if (!cfg.compiled || cfg.runner != "native-harness") return false;
+    QMutexLocker lock(&s_rejectedMutex);
+    return !s_rejected.contains(toolchainKey(cfg));
+#else
+    Q_UNUSED(cfg);
+    return false;
+#endif
+}
+
+bool NativeHarness::install(const QString &dir) {
+    QFile file(dir + "/" + SourceName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(HarnessSource);
+    file.close();
+    return true;
+}
+
+void NativeHarness::uninstall(const QString &dir) {
+    QFile::remove(dir + "/" + SourceName);
+}
+
+bool NativeHarness::isInstalled(const QString &dir) {
+    return QFile::exists(dir + "/" + SourceName);
+}
+
+QStringList NativeHarness::compileArgs(const LanguageConfig &cfg, const QString &dir) {
+    QStringList args = cfg.expandArgs(cfg.compileArgs, dir);
+    if (isInstalled(dir)) args << SourceName;
+    return args;
+}
+
+bool NativeHarness::isHarnessError(const QString &compilerOutput) {
+    // Diagnostics name the file, and its functions all start with sf_harness
+    return compilerOutput.contains("sf_harness");
+}
+
+void NativeHarness::reject(const LanguageConfig &cfg) {
+    QMutexLocker lock(&s_rejectedMutex);
+    s_rejected.insert(toolchainKey(cfg));
+}
+
+QString NativeHarness::toolchainKey(const LanguageConfig &cfg) {
+    return cfg.id + '\n' + cfg.compileCommand + '\n' + cfg.compileArgs.join('\n');
+}
+
+NativeHarness::NativeHarness(QObject *parent) : QObject(parent) {}
+
+NativeHarness::~NativeHarness() {
+    stop();
+}
+
+bool NativeHarness::start(const LanguageConfig &cfg, const QString &dir) {
+    stop();
+    m_cfg = cfg;
+    m_dir = dir;
+    m_unavailable = !isEnabled(cfg) || !isInstalled(dir);
+    if (m_unavailable) return false;
+    return launch();
+}
+
+bool NativeHarness::launch() {
+    m_process = new QProcess(this);
+    m_process->setWorkingDirectory(m_dir);
+    m_process->setStandardErrorFile(QProcess::nullDevice());
+    ProcessGroup::isolate(*m_process);
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (auto it = m_cfg.environment.begin(); it != m_cfg.environment.end(); ++it) {
+        env.insert(it.key(), m_cfg.expand(it.value(), m_dir));
+    }
+    env.insert("SYNTAXFLOW_HARNESS", "1");
+    m_process->setProcessEnvironment(env);
+
+    m_process->start(m_cfg.expand(m_cfg.runCommand, m_dir), m_cfg.expandArgs(m_cfg.runArgs, m_dir));
+
+    if (!m_process->waitForStarted(5000)) {
+        qWarning() << "Failed to start native harness:" << m_process->errorString();
+        stop();
+        m_unavailable = true;
+        return false;
+    }
+    return true;
+}
+
+void NativeHarness::stop() {
+    if (!m_process) return;
+
+    // The test in flight has its own group, outside the harness's
+    if (m_testPgid > 0) {
+        ProcessGroup::killTree(m_testPgid);
+        m_testPgid = 0;
+    }
+
+    if (m_process->state() != QProcess::NotRunning) {
+        // EOF on the control channel makes the harness exit on its own
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(200)) {
+            ProcessGroup::killTree(m_process->processId());
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+    }
+    delete m_process;
+    m_process = nullptr;
+    m_ready = false;
+}
+
+bool NativeHarness::isRunning() const {
+    return m_process && m_process->state() != QProcess::NotRunning;
+}
+
+bool NativeHarness::readLine(QByteArray &line, int msecs) {
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!m_process->canReadLine()) {
+        const int remaining = msecs - int(timer.elapsed());
+        if (remaining <= 0 || m_process->state() == QProcess::NotRunning) return false;
+        m_process->waitForReadyRead(remaining);
+    }
+
+    line = m_process->readLine().trimmed();
+    return true;
+}
+
+bool NativeHarness::waitReady(int msecs) {
+    // A binary without the harness would run main() on the control pipe
+    // instead, so anything but READY means the harness is not there.
+    QByteArray line;
+    if (!readLine(line, msecs) || line != "READY") return false;
+
+    m_ready = true;
+    return true;
+}
+
+NativeHarness::Result NativeHarness::run(const QString &inputPath, const QString &outputPath,
+                                         const QString &errorPath, int timeoutMs) {
+    Result result;
+
+    if (m_unavailable || (!isRunning() && !launch())) {
+        result.message = "Native harness not available";
+        return result;
+    }
+    if (!m_ready && !waitReady(StartupTimeoutMs)) {
+        stop();
+        m_unavailable = true;
+        result.message = "Native harness did not start";
+        return result;
+    }
+
+    const QString args = inputPath + '\t' + outputPath + '\t' + errorPath;
+    m_process->write("RUN " + args.toUtf8() + "\n");
+    m_process->waitForBytesWritten(1000);
+
+    QByteArray line;
+    if (!readLine(line, ReportTimeoutMs) || !line.startsWith("PID ")) {
+        stop();
+        result.message = line.startsWith("FAIL ") ? QString::fromUtf8(line.mid(5))
+                                                  : "Native harness stopped responding";
+        return result;
+    }
+
+    // The child leads its own process group
+    const qint64 pgid = line.mid(4).toLongLong();
+    m_testPgid = pgid;
+
+    if (!readLine(line, timeoutMs)) {
+        if (!isRunning()) {
+            result.message = "Native harness died";
+            stop();
+            return result;
+        }
+        result.kind = Result::Timeout;
+        result.reaped = ProcessGroup::killTree(pgid);
+        m_testPgid = 0;
+        // The harness reaps the child and reports it; the verdict stays TLE
+        if (!readLine(line, ReportTimeoutMs)) stop();
+        return result;
+    }
+
+    const QList<QByteArray> parts = line.split(' ');
+    if (parts.value(0) != "DONE" || parts.size() < 5) {
+        stop();
+        result.message = QString::fromUtf8(line);
+        return result;
+    }
+
+    result.kind = Result::Done;
+    result.exitCode = parts.value(1).toInt();
+    result.wallUs = parts.value(2).toLongLong();
+    result.cpuUs = parts.value(3).toLongLong();
+    result.maxRssKb = parts.value(4).toLongLong();
+    result.reaped = ProcessGroup::reap(pgid);
+    m_testPgid = 0;
+    return result;
+}
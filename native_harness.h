@@ -0,0 +1,84 @@
+#ifndef NATIVE_HARNESS_H
+#define NATIVE_HARNESS_H
+
+#include <QObject>
+#include <QProcess>
+#include "language_config.h"
+#include "process_group.h"
+#include <QMutex>
+#include <QSet>
+
+// Fork server for compiled C/C++ solutions. A small C file (embedded in
+// native_harness.cpp) is compiled into the solution; when the binary is
+// started in harness mode a constructor stops before main(), after the
+// loader and the runtimes are initialised, and forks once per test with
+// stdin/stdout/stderr redirected to files. Each test therefore starts from
+// a warm image and only the forked child's lifetime is timed.
+//
+// The harness is only linked in when the language's runner is
+// "native-harness" and the compiler accepts it; otherwise the binary is
+// the plain solution and tests go through the normal exec path.
+class NativeHarness : public QObject {
+    Q_OBJECT
+
+public:
+    struct Result {
+        enum Kind {
+            Done,       // Test process exited (or was killed by a signal)
+            Timeout,    // Test process killed after timeoutMs
+            Failed      // Harness unusable; caller should fall back to exec
+        };
+        Kind kind = Failed;
+        int exitCode = 0;        // 128 + signal when killed by a signal
+        qint64 wallUs = 0;
+        qint64 cpuUs = 0;
+        qint64 maxRssKb = 0;
+        ReapStats reaped;        // Leftovers of the test's process group
+        QString message;
+    };
+
+    static const char *SourceName;
+
+    // Compile-side helpers shared by CodeRunner and SpeculativeBuilder
+    static bool isEnabled(const LanguageConfig &cfg);
+    static bool install(const QString &dir);
+    static void uninstall(const QString &dir);
+    static bool isInstalled(const QString &dir);
+    // cfg.compileArgs expanded, plus the harness source when installed in dir
+    static QStringList compileArgs(const LanguageConfig &cfg, const QString &dir);
+    // Whether a failed compile's output blames the harness, not the solution
+    static bool isHarnessError(const QString &compilerOutput);
+    // Remembers that this compiler setup rejects the harness; isEnabled()
+    // is false for it from then on, so later builds compile once
+    static void reject(const LanguageConfig &cfg);
+
+    explicit NativeHarness(QObject *parent = nullptr);
+    ~NativeHarness();
+
+    // Starts the solution binary in dir in harness mode. Returns false when
+    // the binary was built without the harness.
+    bool start(const LanguageConfig &cfg, const QString &dir);
+    void stop();
+    bool isRunning() const;
+
+    Result run(const QString &inputPath, const QString &outputPath,
+               const QString &errorPath, int timeoutMs);
+
+private:
+    bool launch();
+    bool waitReady(int msecs);
+    bool readLine(QByteArray &line, int msecs);
+    static QString toolchainKey(const LanguageConfig &cfg);
+
+    static QMutex s_rejectedMutex;
+    static QSet<QString> s_rejected;   // Toolchains, see toolchainKey()
+
+    QProcess *m_process = nullptr;
+    LanguageConfig m_cfg;
+    QString m_dir;
+    qint64 m_testPgid = 0;       // Group of the test currently running
+    bool m_ready = false;
+    bool m_unavailable = false;   // Don't relaunch a harness that failed to start
+};
+
+#endif // NATIVE_HARNESS_H
@@ -1,16 +1,133 @@
 #pragma once
 #include <QString>
 #include <QStringList>
-#include <qregularexpression.h>
+#include <QByteArray>
+#include <QByteArrayView>
 class OutputNormalizer {
 public:
+    // Whitespace is what "\s" matched in the QRegularExpression this used
+    // to split on: without UseUnicodePropertiesOption that is the six ASCII
+    // space characters only, so U+00A0 and other Unicode spaces are part of
+    // a token. Both overloads and the digest share this one definition.
     static QStringList tokenize(const QString &s) {
-        // Split by ANY whitespace
-        return s.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        QStringList tokens;
+        qsizetype start = -1;
+        for (qsizetype i = 0; i <= s.size(); ++i) {
+            const bool space = i == s.size() || (s[i].unicode() < 0x80 && isSpace(char(s[i].unicode())));
+            if (space && start >= 0) {
+                tokens.append(s.mid(start, i - start));
+                start = -1;
+            } else if (!space && start < 0) {
+                start = i;
+            }
+        }
+        return tokens;
     }
 
     static bool equals(const QString &actual,
                        const QString &expected) {
         return tokenize(actual) == tokenize(expected);
     }
+
+    // Same comparison straight on UTF-8 bytes (e.g. a memory-mapped output
+    // file) without building any strings. The whitespace set is all ASCII,
+    // so no byte of a multi-byte UTF-8 sequence is ever taken for a space.
+    static bool equals(QByteArrayView actual, QByteArrayView expected) {
+        qsizetype i = 0, j = 0;
+        const qsizetype n = actual.size(), m = expected.size();
+        for (;;) {
+            while (i < n && isSpace(actual[i])) ++i;
+            while (j < m && isSpace(expected[j])) ++j;
+            if (i == n || j == m) return i == n && j == m;
+
+            while (i < n && j < m && !isSpace(actual[i]) && actual[i] == expected[j]) {
+                ++i;
+                ++j;
+            }
+            const bool actualEnd = i == n || isSpace(actual[i]);
+            const bool expectedEnd = j == m || isSpace(expected[j]);
+            if (!actualEnd || !expectedEnd) return false;
+        }
+    }
+
+    // Hash of the token sequence, the same one equals() compares. Bytes can
+    // be fed in chunks of any size, a token may straddle two chunks, and
+    // nothing is buffered; two outputs are equal exactly when their digests
+    // are (barring a 128-bit collision).
+    class Digest {
+    public:
+        void add(QByteArrayView chunk) {
+            for (char c : chunk) {
+                if (isSpace(c)) {
+                    m_inToken = false;
+                    continue;
+                }
+                if (!m_inToken) {
+                    // Tokens can't contain a space, so it marks the boundary
+                    if (m_tokens > 0) mix(' ');
+                    m_inToken = true;
+                    m_tokens++;
+                }
+                mix(uchar(c));
+            }
+        }
+
+        qsizetype tokens() const { return m_tokens; }
+
+        QByteArray toHex() const {
+            return QByteArray::number(m_fnv, 16).rightJustified(16, '0') +
+                   QByteArray::number(m_poly, 16).rightJustified(16, '0') + ':' +
+                   QByteArray::number(m_tokens);
+        }
+
+        bool operator==(const Digest &other) const {
+            return m_fnv == other.m_fnv && m_poly == other.m_poly && m_tokens == other.m_tokens;
+        }
+        bool operator!=(const Digest &other) const { return !(*this == other); }
+
+    private:
+        void mix(uchar c) {
+            m_fnv = (m_fnv ^ c) * 1099511628211ULL;
+            m_poly = m_poly * 0x9E3779B97F4A7C15ULL + c + 1;
+        }
+
+        quint64 m_fnv = 14695981039346656037ULL;
+        quint64 m_poly = 0;
+        qsizetype m_tokens = 0;
+        bool m_inToken = false;
+    };
+
+    static Digest digest(QByteArrayView bytes) {
+        Digest d;
+        d.add(bytes);
+        return d;
+    }
+
+    // Index of the first token that differs (or that only one side has),
+    // with the byte offset where it starts on each side; -1 when equal
+    static qsizetype firstMismatch(QByteArrayView actual, QByteArrayView expected,
+                                   qsizetype &actualPos, qsizetype &expectedPos) {
+        qsizetype i = 0, j = 0, token = 0;
+        const qsizetype n = actual.size(), m = expected.size();
+        for (;; ++token) {
+            while (i < n && isSpace(actual[i])) ++i;
+            while (j < m && isSpace(expected[j])) ++j;
+            actualPos = i;
+            expectedPos = j;
+            if (i == n || j == m) return i == n && j == m ? -1 : token;
+
+            while (i < n && j < m && !isSpace(actual[i]) && actual[i] == expected[j]) {
+                ++i;
+                ++j;
+            }
+            const bool actualEnd = i == n || isSpace(actual[i]);
+            const bool expectedEnd = j == m || isSpace(expected[j]);
+            if (!actualEnd || !expectedEnd) return token;
+        }
+    }
+
+private:
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
 };
@@ -0,0 +1,122 @@
+#include "problem_facets.h"
+#include "catalog_index.h"
+#include "progressmanager.h"
+
+#include <QtAlgorithms>
+#include <algorithm>
+
+Bitset::Bitset(int size, bool value)
+    : m_words((size + 63) / 64, value ? ~quint64(0) : 0), m_size(size) {
+    // Keep the bits past the end clear so count() stays exact
+    if (value && (size & 63)) m_words.last() = (quint64(1) << (size & 63)) - 1;
+}
+
+void Bitset::set(int i, bool value) {
+    const quint64 bit = quint64(1) << (i & 63);
+    if (value) {
+        m_words[i >> 6] |= bit;
+    } else {
+        m_words[i >> 6] &= ~bit;
+    }
+}
+
+int Bitset::count() const {
+    int n = 0;
+    for (quint64 word : m_words) n += qPopulationCount(word);
+    return n;
+}
+
+Bitset &Bitset::operator&=(const Bitset &other) {
+    for (qsizetype w = 0; w < m_words.size(); ++w) m_words[w] &= other.m_words[w];
+    return *this;
+}
+
+Bitset &Bitset::operator|=(const Bitset &other) {
+    for (qsizetype w = 0; w < m_words.size(); ++w) m_words[w] |= other.m_words[w];
+    return *this;
+}
+
+Bitset &Bitset::andNot(const Bitset &other) {
+    for (qsizetype w = 0; w < m_words.size(); ++w) m_words[w] &= ~other.m_words[w];
+    return *this;
+}
+
+void ProblemFacets::build(const CatalogIndex &catalog, const ProgressManager *progress) {
+    m_size = catalog.size();
+    m_difficulties = QList<Bitset>(catalog.difficulties().size(), Bitset(m_size));
+    m_topics = QList<Bitset>(catalog.topics().size(), Bitset(m_size));
+    m_solved = Bitset(m_size);
+    m_starred = Bitset(m_size);
+    m_attempts = QList<int>(m_size, 0);
+    m_lastSolved = QList<qint64>(m_size, 0);
+
+    for (int i = 0; i < m_size; ++i) {
+        m_difficulties[catalog.difficultyId(i)].set(i);
+        for (int topic : catalog.topicIds(i)) m_topics[topic].set(i);
+        update(i, catalog.id(i), progress);
+    }
+}
+
+void ProblemFacets::update(int index, const QString &id, const ProgressManager *progress) {
+    if (index < 0 || index >= m_size) return;
+    m_solved.set(index, progress->isSolved(id));
+    m_starred.set(index, progress->isStarred(id));
+    m_attempts[index] = progress->attempts(id);
+    const QDateTime solvedAt = progress->lastSolved(id);
+    m_lastSolved[index] = solvedAt.isValid() ? solvedAt.toSecsSinceEpoch() : 0;
+}
+
+Bitset ProblemFacets::matching(const Filter &filter) const {
+    Bitset result(m_size, true);
+
+    auto facet = [&](const QList<Bitset> &sets, const QSet<int> &selected) {
+        if (selected.isEmpty()) return;
+        Bitset any(m_size);
+        for (int id : selected) {
+            if (id >= 0 && id < sets.size()) any |= sets[id];
+        }
+        result &= any;
+    };
+    facet(m_difficulties, filter.difficulties);
+    facet(m_topics, filter.topics);
+
+    switch (filter.status) {
+    case Solved:   result &= m_solved; break;
+    case Unsolved: result.andNot(m_solved); break;
+    case Starred:  result &= m_starred; break;
+    case AnyStatus: break;
+    }
+    return result;
+}
+
+QList<int> ProblemFacets::apply(const Filter &filter, const QList<int> &indexes) const {
+    // Record numbers outside the catalog the facets were built for are
+    // dropped, whichever path they take
+    QList<int> out;
+    if (filter.difficulties.isEmpty() && filter.topics.isEmpty() && filter.status == AnyStatus) {
+        out.reserve(indexes.size());
+        for (int i : indexes) {
+            if (i >= 0 && i < m_size) out.append(i);
+        }
+    } else {
+        const Bitset allowed = matching(filter);
+        out.reserve(qMin(indexes.size(), qsizetype(allowed.count())));
+        for (int i : indexes) {
+            if (i >= 0 && i < m_size && allowed.test(i)) out.append(i);
+        }
+    }
+
+    switch (filter.sort) {
+    case MostAttempts:
+        std::stable_sort(out.begin(), out.end(),
+                         [this](int a, int b) { return m_attempts[a] > m_attempts[b]; });
+        break;
+    case RecentlySolved:
+        std::stable_sort(out.begin(), out.end(),
+                         [this](int a, int b) { return m_lastSolved[a] > m_lastSolved[b]; });
+        break;
+    case CatalogOrder:
+        break;
+    }
+    return out;
+}
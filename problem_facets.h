@@ -0,0 +1,66 @@
+#ifndef PROBLEM_FACETS_H
+#define PROBLEM_FACETS_H
+
+#include <QList>
+#include <QSet>
+#include <QString>
+
+class CatalogIndex;
+class ProgressManager;
+
+// Fixed-size bitset over catalog record numbers; the set operations work a
+// 64-bit word at a time
+class Bitset {
+public:
+    Bitset() = default;
+    explicit Bitset(int size, bool value = false);
+
+    int size() const { return m_size; }
+    bool test(int i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+    void set(int i, bool value = true);
+    int count() const;
+
+    Bitset &operator&=(const Bitset &other);
+    Bitset &operator|=(const Bitset &other);
+    Bitset &andNot(const Bitset &other);
+
+private:
+    QList<quint64> m_words;
+    int m_size = 0;
+};
+
+// Per-facet bitsets over the catalog: one per difficulty and per topic from
+// problems.json, plus solved and starred from ProgressManager. A filter is
+// an OR within each facet and an AND across them. Progress is applied one
+// problem at a time as it changes.
+class ProblemFacets {
+public:
+    enum Status { AnyStatus, Solved, Unsolved, Starred };
+    enum Sort { CatalogOrder, MostAttempts, RecentlySolved };
+
+    struct Filter {
+        QSet<int> difficulties;   // Difficulty ids; empty means any
+        QSet<int> topics;         // Topic ids; empty means any
+        Status status = AnyStatus;
+        Sort sort = CatalogOrder;
+    };
+
+    void build(const CatalogIndex &catalog, const ProgressManager *progress);
+    void update(int index, const QString &id, const ProgressManager *progress);
+
+    Bitset matching(const Filter &filter) const;
+    // Keeps the records that pass the filter, in the filter's order; an
+    // unsorted filter keeps the order they came in (e.g. search ranking)
+    QList<int> apply(const Filter &filter, const QList<int> &indexes) const;
+
+private:
+    int m_size = 0;
+    QList<Bitset> m_difficulties;
+    QList<Bitset> m_topics;
+    Bitset m_solved;
+    Bitset m_starred;
+    QList<int> m_attempts;
+    QList<qint64> m_lastSolved;   // Seconds since epoch, 0 if never solved
+};
+
+#endif // PROBLEM_FACETS_H
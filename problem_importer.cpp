@@ -0,0 +1,394 @@
+#include "problem_importer.h"
+#include "catalog_index.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringDecoder>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr const char *StatementName = "statement.html";
+constexpr const char *DefaultDifficulty = "Medium";
+
+// Combines the hashes of a problem's parts, in order
+constexpr quint64 HashSeed = 14695981039346656037ULL;
+constexpr quint64 HashPrime = 1099511628211ULL;
+
+// One problem directory of the archive
+struct Source {
+    QString dir;          // Absolute
+    QString relative;     // To the archive, for messages
+    QString difficulty;
+    QString title;
+    quint64 hash = 0;     // Of statement and tests, 0 until read
+    QString error;
+    // Given once the archive is deduplicated
+    QString id;
+    QString path;         // Relative to problems/
+};
+
+// What only the write needs; read again then so the whole archive is
+// never held in memory at once
+struct Content {
+    QString description;
+    QList<QPair<QString, QString>> tests;   // Input and expected output
+};
+
+// Calls fn(i) for every i below count, spread over all cores
+template <typename Fn>
+void parallelFor(int count, const Fn &fn) {
+    std::atomic<int> next{0};
+    auto work = [&]() {
+        for (int i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> workers;
+    const int threads = qBound(1, QThread::idealThreadCount(), qMax(1, count));
+    for (int t = 1; t < threads; ++t) workers.emplace_back(work);
+    work();
+    for (std::thread &worker : workers) worker.join();
+}
+
+quint64 mix(quint64 hash, const QString &part) {
+    return (hash ^ CatalogIndex::hash(part.toUtf8())) * HashPrime;
+}
+
+bool readText(const QString &path, const QString &name, QString &text, QString &error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = "cannot read " + name;
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    if (bytes.contains('\0')) {
+        error = name + " is not text";
+        return false;
+    }
+    QStringDecoder decoder(QStringDecoder::Utf8);
+    text = decoder(bytes);
+    if (decoder.hasError()) {
+        error = name + " is not valid UTF-8";
+        return false;
+    }
+    text.replace("\r\n", "\n");
+    return true;
+}
+
+QString plainText(QString html) {
+    static const QRegularExpression tags("<[^>]*>");
+    html.replace(tags, " ");
+    html.replace("&nbsp;", " ");
+    html.replace("&lt;", "<");
+    html.replace("&gt;", ">");
+    html.replace("&quot;", "\"");
+    html.replace("&#39;", "'");
+    html.replace("&amp;", "&");
+    return html.simplified();
+}
+
+// "1.in" before "2.in" before "10.in"; names that are not numbers after
+bool testOrder(const QString &a, const QString &b) {
+    bool aNumber = false;
+    bool bNumber = false;
+    const qlonglong x = QFileInfo(a).completeBaseName().toLongLong(&aNumber);
+    const qlonglong y = QFileInfo(b).completeBaseName().toLongLong(&bNumber);
+    if (aNumber && bNumber && x != y) return x < y;
+    if (aNumber != bNumber) return aNumber;
+    return a < b;
+}
+
+QString difficultyOf(const QString &relative) {
+    for (const QString &part : relative.split('/')) {
+        const QString name = part.toLower();
+        if (name == "easy" || name == "medium" || name == "hard") {
+            return name.left(1).toUpper() + name.mid(1);
+        }
+    }
+    return DefaultDifficulty;
+}
+
+QString idFor(const QString &name) {
+    QString id;
+    for (QChar c : name.toLower()) {
+        if (c.isLetterOrNumber()) {
+            id += c;
+        } else if (!id.isEmpty() && !id.endsWith('_')) {
+            id += '_';
+        }
+    }
+    while (id.endsWith('_')) id.chop(1);
+    return id.isEmpty() ? QString("problem") : id;
+}
+
+// Validates and hashes a problem; with content, also keeps what the
+// problem file is written from
+void readProblem(Source &source, Content *content) {
+    static const auto options = QRegularExpression::CaseInsensitiveOption |
+                                QRegularExpression::DotMatchesEverythingOption;
+    static const QRegularExpression titleTag("<title\\b[^>]*>(.*?)</title\\s*>", options);
+    static const QRegularExpression headingTag("<h1\\b[^>]*>(.*?)</h1\\s*>", options);
+    static const QRegularExpression bodyTag("<body\\b[^>]*>(.*?)</body\\s*>", options);
+    static const QRegularExpression unused("<(head|script|style)\\b[^>]*>.*?</\\1\\s*>", options);
+    static const QRegularExpression spaces("\\s+");
+
+    const QDir dir(source.dir);
+    QString statement;
+    if (!readText(dir.filePath(StatementName), StatementName, statement, source.error)) return;
+
+    const QRegularExpressionMatch body = bodyTag.match(statement);
+    QString description = body.hasMatch() ? body.captured(1) : statement;
+    QString title = plainText(titleTag.match(statement).captured(1));
+    if (title.isEmpty()) {
+        // The heading becomes the title instead of repeating it below
+        const QRegularExpressionMatch heading = headingTag.match(description);
+        title = plainText(heading.captured(1));
+        if (heading.hasMatch()) description.remove(heading.capturedStart(), heading.capturedLength());
+    }
+    if (title.isEmpty()) title = QFileInfo(source.dir).fileName();
+    description.remove(unused);
+    // ProblemPanel turns newlines into breaks; HTML already has its own
+    description = description.replace(spaces, " ").trimmed();
+
+    const QDir testsDir(dir.filePath("tests"));
+    QStringList inputs = testsDir.entryList({"*.in"}, QDir::Files);
+    const QStringList outputs = testsDir.entryList({"*.out"}, QDir::Files);
+    QSet<QString> unpaired;
+    for (const QString &output : outputs) unpaired.insert(QFileInfo(output).completeBaseName());
+    for (const QString &input : inputs) {
+        if (!unpaired.remove(QFileInfo(input).completeBaseName())) {
+            source.error = "tests/" + input + " has no .out";
+            return;
+        }
+    }
+    if (!unpaired.isEmpty()) {
+        source.error = "tests/" + *unpaired.constBegin() + ".out has no .in";
+        return;
+    }
+    if (inputs.isEmpty()) {
+        source.error = "no tests";
+        return;
+    }
+    std::sort(inputs.begin(), inputs.end(), testOrder);
+
+    quint64 hash = mix(mix(HashSeed, title), description);
+    for (const QString &input : inputs) {
+        const QString output = QFileInfo(input).completeBaseName() + ".out";
+        QString in, out;
+        if (!readText(testsDir.filePath(input), "tests/" + input, in, source.error) ||
+            !readText(testsDir.filePath(output), "tests/" + output, out, source.error)) {
+            return;
+        }
+        hash = mix(mix(hash, in), out);
+        if (content) content->tests.append({in, out});
+    }
+
+    source.title = title;
+    source.hash = hash;
+    if (content) content->description = description;
+}
+
+QJsonObject problemJson(const Source &source, const Content &content, const QString &category) {
+    QJsonArray tests;
+    for (qsizetype i = 0; i < content.tests.size(); ++i) {
+        QJsonObject test{{"input", content.tests[i].first}, {"output", content.tests[i].second}};
+        if (i == 0) test["sample"] = true;
+        tests.append(test);
+    }
+
+    return QJsonObject{
+        {"id", source.id},
+        {"title", source.title},
+        {"difficulty", source.difficulty},
+        {"category", category},
+        {"tags", QJsonArray()},
+        {"description", content.description},
+        {"sampleInput", content.tests.first().first.trimmed()},
+        {"sampleOutput", content.tests.first().second.trimmed()},
+        {"testCases", tests},
+        {"importHash", QString::number(source.hash, 16)},
+    };
+}
+
+} // namespace
+
+bool ProblemImporter::import(const QString &sourceDir, const QString &rootDir,
+                             Report &report, QString &error) {
+    const QDir root(rootDir);
+    const QString catalogPath = root.filePath("problems.json");
+    const QString problemsDir = root.filePath("problems");
+
+    QJsonArray catalog;
+    if (QFile::exists(catalogPath)) {
+        QFile file(catalogPath);
+        const QJsonDocument doc = file.open(QIODevice::ReadOnly)
+            ? QJsonDocument::fromJson(file.readAll()) : QJsonDocument();
+        if (!doc.isArray()) {
+            error = "Cannot read " + catalogPath;
+            return false;
+        }
+        catalog = doc.array();
+    }
+
+    // Opened before anything is written, so the refresh at the end only
+    // reads the new problems
+    CatalogIndex index;
+    const bool indexed = !catalog.isEmpty() && index.open(catalogPath, problemsDir);
+
+    // What the catalog already has: ids, and the content of earlier imports
+    QSet<QString> ids;
+    QStringList existing;
+    for (const QJsonValue &value : catalog) {
+        const QJsonObject entry = value.toObject();
+        ids.insert(entry.value("id").toString());
+        existing.append(QDir(problemsDir).filePath(entry.value("path").toString()));
+    }
+    std::vector<quint64> existingHashes(existing.size(), 0);
+    parallelFor(int(existing.size()), [&](int i) {
+        QFile file(existing.at(i));
+        if (!file.open(QIODevice::ReadOnly)) return;
+        const QByteArray bytes = file.readAll();
+        if (!bytes.contains("\"importHash\"")) return;
+        const QString hash = QJsonDocument::fromJson(bytes).object().value("importHash").toString();
+        existingHashes[i] = hash.toULongLong(nullptr, 16);
+    });
+    QSet<quint64> seen(existingHashes.begin(), existingHashes.end());
+    seen.remove(0);
+
+    const QDir archive(QDir::cleanPath(QFileInfo(sourceDir).absoluteFilePath()));
+    QList<Source> sources;
+    QDirIterator it(archive.path(), {StatementName}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        Source source;
+        source.dir = it.nextFileInfo().absolutePath();
+        source.relative = archive.relativeFilePath(source.dir);
+        source.difficulty = difficultyOf(source.relative);
+        sources.append(source);
+    }
+    // Archive order decides which of two duplicates is kept
+    std::sort(sources.begin(), sources.end(),
+              [](const Source &a, const Source &b) { return a.relative < b.relative; });
+    report.found = int(sources.size());
+    if (sources.isEmpty()) {
+        error = QString(StatementName) + " not found under " + sourceDir;
+        return false;
+    }
+
+    Source *read = sources.data();
+    parallelFor(int(sources.size()), [&](int i) { readProblem(read[i], nullptr); });
+
+    // Each accepted problem's file is created empty here, on this thread,
+    // and never replaces anything: a name taken on disk or by a catalog
+    // entry gets the next suffix. The rollback removes only these files.
+    QSet<QString> claimed;
+    for (const QString &path : existing) claimed.insert(QDir::cleanPath(path));
+    QStringList created;
+    auto rollback = [&]() {
+        for (const QString &path : created) QFile::remove(path);
+    };
+
+    QList<int> accepted;
+    for (int i = 0; i < sources.size(); ++i) {
+        Source &source = sources[i];
+        if (!source.error.isEmpty()) {
+            report.rejected << source.relative + ": " + source.error;
+            continue;
+        }
+        if (seen.contains(source.hash)) {
+            ++report.duplicates;
+            continue;
+        }
+        seen.insert(source.hash);
+
+        const QString dir = source.difficulty.toLower();
+        QDir(problemsDir).mkpath(dir);
+        const QString base = idFor(QFileInfo(source.dir).fileName());
+        QString target;
+        for (int n = 1;; ++n) {
+            source.id = n == 1 ? base : base + '_' + QString::number(n);
+            source.path = dir + '/' + source.id + ".json";
+            target = QDir::cleanPath(QDir(problemsDir).filePath(source.path));
+            if (!ids.contains(source.id) && !claimed.contains(target) && !QFile::exists(target)) break;
+        }
+        QFile placeholder(target);
+        if (!placeholder.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+            error = "Cannot create " + target;
+            rollback();
+            return false;
+        }
+        created.append(target);
+        ids.insert(source.id);
+        claimed.insert(target);
+        accepted.append(i);
+    }
+
+    const QString category = QFileInfo(archive.path()).fileName();
+    std::vector<QString> failures(accepted.size());
+    parallelFor(int(accepted.size()), [&](int n) {
+        const Source &scanned = sources.at(accepted.at(n));
+        Source source = scanned;
+        Content content;
+        readProblem(source, &content);
+        if (!source.error.isEmpty() || source.hash != scanned.hash) {
+            failures[n] = source.relative + " changed while importing";
+            return;
+        }
+
+        QSaveFile file(QDir(problemsDir).filePath(source.path));
+        const QByteArray json = QJsonDocument(problemJson(source, content, category)).toJson();
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+            failures[n] = "Cannot write " + file.fileName();
+            return;
+        }
+    });
+
+    for (const QString &failure : failures) {
+        if (!failure.isEmpty()) {
+            error = failure;
+            rollback();
+            return false;
+        }
+    }
+
+    // The one step that makes the import visible
+    for (int i : accepted) {
+        const Source &source = sources.at(i);
+        catalog.append(QJsonObject{
+            {"id", source.id},
+            {"title", source.title},
+            {"difficulty", source.difficulty},
+            {"path", source.path},
+            {"topics", QJsonArray()},
+        });
+    }
+    if (!accepted.isEmpty()) {
+        QSaveFile file(catalogPath);
+        const QByteArray json = QJsonDocument(catalog).toJson();
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+            error = "Cannot write " + catalogPath;
+            rollback();
+            return false;
+        }
+
+        // Only the new files are read; the rest keep their indexed hashes
+        const bool refreshed = indexed ? index.refresh({}) : index.open(catalogPath, problemsDir);
+        if (!refreshed) qWarning() << "Catalog index not updated; it is rebuilt on next start";
+    }
+
+    report.imported = int(accepted.size());
+    qDebug() << "Imported" << report.imported << "of" << report.found << "problems,"
+             << report.duplicates << "duplicates," << report.rejected.size() << "rejected";
+    return true;
+}
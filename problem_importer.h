@@ -0,0 +1,44 @@
+#ifndef PROBLEM_IMPORTER_H
+#define PROBLEM_IMPORTER_H
+
+#include <QString>
+#include <QStringList>
+
+// Authoring tool that brings in problem archives laid out as
+//   <problem>/statement.html
+//   <problem>/tests/<name>.in and <problem>/tests/<name>.out
+// and turns each problem into a problems/<difficulty>/<id>.json plus an
+// entry in problems.json.
+//
+// Problems are read, validated and hashed on all cores. A problem is
+// rejected when a test lacks its .in or .out, or a file is not text (NUL
+// bytes or bad UTF-8). A problem whose statement and tests hash the same as
+// one already in the catalog, or earlier in the archive, is skipped; the
+// hash is kept in the problem file as "importHash", so importing the same
+// archive twice adds nothing.
+//
+// The problem files are written first, then problems.json is replaced in
+// one atomic save and the catalog index refreshed; the catalog never lists
+// a half-imported archive. Existing files are never overwritten, and on a
+// failure only the files this import created are removed.
+//
+// The id is the problem directory's name, made unique against the catalog
+// and the files already on disk. The difficulty comes
+// from an easy/medium/hard directory on the way to the problem (Medium when
+// there is none), the category from the archive directory's name.
+//
+// Run as: SyntaxFlow --import <archive dir> <dir with problems.json> [<out.sfpack>]
+class ProblemImporter {
+public:
+    struct Report {
+        int found = 0;
+        int imported = 0;
+        int duplicates = 0;
+        QStringList rejected;   // "<problem dir>: reason"
+    };
+
+    static bool import(const QString &sourceDir, const QString &rootDir,
+                       Report &report, QString &error);
+};
+
+#endif // PROBLEM_IMPORTER_H
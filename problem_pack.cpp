@@ -0,0 +1,242 @@
+#include "problem_pack.h"
+#include "catalog_index.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char Magic[8] = {'S', 'F', 'P', 'A', 'C', 'K', '\0', '\0'};
+
+// Compressed copies must save at least this fraction to be kept
+constexpr double MinSaving = 0.1;
+
+// Byte order of the UTF-8 names, which is how the entries are sorted
+int compareNames(QByteArrayView a, QByteArrayView b) {
+    const int c = memcmp(a.data(), b.data(), size_t(qMin(a.size(), b.size())));
+    if (c != 0) return c;
+    return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+void put16(QByteArray &out, quint16 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void put32(QByteArray &out, quint32 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+void put64(QByteArray &out, quint64 v) {
+    v = qToLittleEndian(v);
+    out.append(reinterpret_cast<const char *>(&v), sizeof v);
+}
+
+qint64 aligned(qint64 offset, int alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+bool ProblemPack::open(const QString &path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+    m_size = m_file.size();
+    const uchar *data = m_size >= HeaderSize ? m_file.map(0, m_size) : nullptr;
+    if (!data || memcmp(data, Magic, sizeof Magic) != 0 ||
+        qFromLittleEndian<quint32>(data + 8) != Version) {
+        qWarning() << "Not a problem pack:" << path;
+        close();
+        return false;
+    }
+
+    m_data = data;
+    m_count = qFromLittleEndian<quint32>(data + 12);
+    m_names = qFromLittleEndian<quint32>(data + 16);
+    const quint32 namesSize = qFromLittleEndian<quint32>(data + 20);
+    bool valid = HeaderSize + qint64(m_count) * EntrySize <= m_names && m_names + qint64(namesSize) <= m_size;
+
+    // Every entry's name and data are checked here once, so find(), name()
+    // and the readers can use the table as is
+    for (quint32 i = 0; valid && i < m_count; ++i) {
+        const uchar *e = entry(int(i));
+        const quint64 nameEnd = quint64(qFromLittleEndian<quint32>(e)) + qFromLittleEndian<quint16>(e + 4);
+        const quint64 offset = qFromLittleEndian<quint64>(e + 16);
+        const quint32 stored = qFromLittleEndian<quint32>(e + 8);
+        valid = nameEnd <= namesSize && offset <= quint64(m_size) && stored <= quint64(m_size) - offset;
+    }
+    if (!valid) {
+        qWarning() << "Corrupt problem pack:" << path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ProblemPack::close() {
+    if (m_data) m_file.unmap(const_cast<uchar *>(m_data));
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_count = 0;
+    m_names = 0;
+}
+
+QString ProblemPack::name(int index) const {
+    const uchar *e = entry(index);
+    const quint32 offset = qFromLittleEndian<quint32>(e);
+    const quint16 length = qFromLittleEndian<quint16>(e + 4);
+    return QString::fromUtf8(reinterpret_cast<const char *>(m_data + m_names + offset), length);
+}
+
+int ProblemPack::find(const QString &name) const {
+    if (!m_data) return -1;
+    const QByteArray key = name.toUtf8();
+
+    int lo = 0;
+    int hi = int(m_count) - 1;
+    while (lo <= hi) {
+        const int mid = (lo + hi) / 2;
+        const uchar *e = entry(mid);
+        const QByteArrayView probe(m_data + m_names + qFromLittleEndian<quint32>(e),
+                                   qFromLittleEndian<quint16>(e + 4));
+        const int c = compareNames(probe, key);
+        if (c == 0) return mid;
+        if (c < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+QByteArrayView ProblemPack::rawView(const QString &name) const {
+    const int index = find(name);
+    if (index < 0) return {};
+    const uchar *e = entry(index);
+    const quint16 flags = qFromLittleEndian<quint16>(e + 6);
+    const quint32 stored = qFromLittleEndian<quint32>(e + 8);
+    const quint64 offset = qFromLittleEndian<quint64>(e + 16);
+    if (flags & Compressed) return {};
+    return QByteArrayView(m_data + offset, stored);
+}
+
+QByteArray ProblemPack::read(const QString &name) const {
+    const int index = find(name);
+    if (index < 0) return QByteArray();
+    const uchar *e = entry(index);
+    const quint16 flags = qFromLittleEndian<quint16>(e + 6);
+    const quint32 stored = qFromLittleEndian<quint32>(e + 8);
+    const quint32 size = qFromLittleEndian<quint32>(e + 12);
+    const quint64 offset = qFromLittleEndian<quint64>(e + 16);
+    const quint64 hash = qFromLittleEndian<quint64>(e + 24);
+
+    QByteArray bytes = (flags & Compressed)
+        ? qUncompress(m_data + offset, qsizetype(stored))
+        : QByteArray(reinterpret_cast<const char *>(m_data + offset), stored);
+    if (bytes.size() != qsizetype(size) || CatalogIndex::hash(bytes) != hash) {
+        qWarning() << "Damaged pack entry:" << name << "in" << m_file.fileName();
+        return QByteArray();
+    }
+    return bytes;
+}
+
+bool ProblemPack::write(const QString &rootDir, const QString &packPath, QString &error) {
+    const QDir root(rootDir);
+    const QString catalogPath = root.filePath(CatalogName);
+    const QString problemsDir = root.filePath(ProblemsDir);
+
+    QTemporaryDir temp;
+    const QString indexPath = temp.filePath(IndexName);
+    if (!temp.isValid() || !CatalogIndex::build(catalogPath, problemsDir, indexPath, error)) {
+        if (error.isEmpty()) error = "Cannot create a temporary directory";
+        return false;
+    }
+
+    // Names first: they fix the size of the entry table and name block, so
+    // the data can be streamed after them and the table filled in at the end
+    struct Source {
+        QByteArray name;
+        QString path;
+        bool raw = false;
+    };
+    QList<Source> sources = {{QByteArray(CatalogName), catalogPath, false},
+                             {QByteArray(IndexName), indexPath, true}};
+    QDirIterator it(problemsDir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        sources.append({root.relativeFilePath(path).toUtf8(), path, false});
+    }
+    std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b) {
+        return compareNames(a.name, b.name) < 0;
+    });
+
+    QByteArray names;
+    for (const Source &source : sources) names.append(source.name);
+    const qint64 namesOffset = HeaderSize + qint64(sources.size()) * EntrySize;
+
+    QSaveFile pack(packPath);
+    if (!pack.open(QIODevice::WriteOnly)) {
+        error = "Cannot write " + packPath;
+        return false;
+    }
+
+    QByteArray table;
+    quint32 nameOffset = 0;
+    qint64 offset = namesOffset + names.size();
+    pack.write(QByteArray(namesOffset, '\0'));
+    pack.write(names);
+    for (const Source &source : sources) {
+        QFile file(source.path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = "Cannot read " + source.path;
+            return false;
+        }
+        const QByteArray bytes = file.readAll();
+        QByteArray stored = bytes;
+        bool compressed = false;
+        if (!source.raw) {
+            QByteArray packed = qCompress(bytes, 9);
+            if (packed.size() < bytes.size() * (1.0 - MinSaving)) {
+                stored = packed;
+                compressed = true;
+            }
+        }
+
+        const qint64 start = aligned(offset, Alignment);
+        pack.write(QByteArray(start - offset, '\0'));
+        pack.write(stored);
+        offset = start + stored.size();
+
+        put32(table, nameOffset);
+        put16(table, quint16(source.name.size()));
+        put16(table, compressed ? Compressed : 0);
+        put32(table, quint32(stored.size()));
+        put32(table, quint32(bytes.size()));
+        put64(table, quint64(start));
+        put64(table, CatalogIndex::hash(bytes));
+        nameOffset += quint32(source.name.size());
+    }
+
+    QByteArray header(Magic, sizeof Magic);
+    put32(header, Version);
+    put32(header, quint32(sources.size()));
+    put32(header, quint32(namesOffset));
+    put32(header, quint32(names.size()));
+    header.resize(HeaderSize, '\0');
+
+    if (!pack.seek(0) || pack.write(header + table) != namesOffset || !pack.commit()) {
+        error = "Cannot write " + packPath;
+        return false;
+    }
+
+    qDebug() << "Packed" << sources.size() << "entries," << offset << "bytes";
+    return true;
+}
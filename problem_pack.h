@@ -0,0 +1,71 @@
+#ifndef PROBLEM_PACK_H
+#define PROBLEM_PACK_H
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// .sfpack: a problem set in one file, read in place through a mapping.
+//
+// Layout (little-endian):
+//   header      magic, version, entry count and the offsets below (64 bytes)
+//   entries     32 bytes each, sorted by name: name offset and length,
+//               flags, stored and original size, data offset and the
+//               content hash of the original bytes
+//   names       UTF-8 paths relative to the pack root, e.g.
+//               "problems.json", "problems/easy/two_sum.json"
+//   data        one block per entry, each starting on a 64-byte boundary
+//
+// Entries are zlib-compressed (qCompress) unless that does not pay off or
+// they are meant to be used in place: the prebuilt catalog index is stored
+// raw so CatalogIndex maps it straight out of the pack.
+class ProblemPack {
+public:
+    static constexpr const char *CatalogName = "problems.json";
+    static constexpr const char *IndexName = "catalog.idx";
+    static constexpr const char *ProblemsDir = "problems/";
+
+    ProblemPack() = default;
+    ~ProblemPack() { close(); }
+    ProblemPack(const ProblemPack &) = delete;
+    ProblemPack &operator=(const ProblemPack &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    QString fileName() const { return m_file.fileName(); }
+
+    int size() const { return int(m_count); }
+    QString name(int index) const;
+    bool contains(const QString &name) const { return find(name) >= 0; }
+
+    // Decompressed, hash-checked contents; empty if missing or damaged.
+    // Safe to call from several threads at once.
+    QByteArray read(const QString &name) const;
+    // The bytes inside the mapping, for entries stored raw; empty otherwise
+    QByteArrayView rawView(const QString &name) const;
+
+    // Packs problems.json and problems/ under rootDir, with a freshly built
+    // catalog index
+    static bool write(const QString &rootDir, const QString &packPath, QString &error);
+
+private:
+    static constexpr quint32 Version = 1;
+    static constexpr int HeaderSize = 64;
+    static constexpr int EntrySize = 32;
+    static constexpr int Alignment = 64;
+
+    enum Flags : quint16 { Compressed = 1 };
+
+    int find(const QString &name) const;
+    const uchar *entry(int index) const { return m_data + HeaderSize + qint64(index) * EntrySize; }
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    quint32 m_count = 0;
+    quint32 m_names = 0;
+};
+
+#endif // PROBLEM_PACK_H
@@ -1,4 +1,6 @@
 #include "problem_panel.h"
+#include "problem_repository.h"
+#include "statement_view.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -13,8 +15,8 @@
 
 
 
-ProblemPanel::ProblemPanel(QWidget *parent)
-    : QWidget(parent)
+ProblemPanel::ProblemPanel(ProblemRepository *repo, QWidget *parent)
+    : QWidget(parent), repository(repo), statements(new StatementCache(repo, this))
 {
     setObjectName("problemPanel");
     setStyleSheet(buildStyleSheet());
@@ -85,6 +87,7 @@ void ProblemPanel::buildUI()
     auto *tagsLayout = new QHBoxLayout(tagsContainer);
     tagsLayout->setContentsMargins(0, 6, 0, 0);
     tagsLayout->setSpacing(8);
+    tagsLayout->addStretch();
 
     headerLayout->addLayout(titleRow);
     headerLayout->addLayout(metaRow);
@@ -102,15 +105,11 @@ void ProblemPanel::buildUI()
     auto *descTitle = new QLabel("Description");
     descTitle->setObjectName("sectionTitle");
 
-    descriptionLabel = new QLabel;
-    descriptionLabel->setObjectName("contentLabel");
-    descriptionLabel->setWordWrap(true);
-    descriptionLabel->setTextFormat(Qt::RichText);
-    descriptionLabel->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::LinksAccessibleByMouse);
-    descriptionLabel->setOpenExternalLinks(true);
+    descriptionView = new StatementView;
+    descriptionView->setObjectName("contentLabel");
 
     descLayout->addWidget(descTitle);
-    descLayout->addWidget(descriptionLabel);
+    descLayout->addWidget(descriptionView);
 
     // ═══════════════════════════════════════════════════════════════════
     // TASK SECTION
@@ -135,14 +134,11 @@ void ProblemPanel::buildUI()
     taskHeader->addWidget(taskTitle);
     taskHeader->addStretch();
 
-    taskLabel = new QLabel;
-    taskLabel->setObjectName("taskLabel");
-    taskLabel->setWordWrap(true);
-    taskLabel->setTextFormat(Qt::RichText);
-    taskLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    taskView = new StatementView;
+    taskView->setObjectName("taskView");
 
     taskLayout->addLayout(taskHeader);
-    taskLayout->addWidget(taskLabel);
+    taskLayout->addWidget(taskView);
 
     taskOuterLayout->addWidget(taskSection);
 
@@ -170,14 +166,11 @@ void ProblemPanel::buildUI()
     inputHeader->addWidget(inputTitle);
     inputHeader->addStretch();
 
-    inputFormatLabel = new QLabel;
-    inputFormatLabel->setObjectName("formatLabel");
-    inputFormatLabel->setWordWrap(true);
-    inputFormatLabel->setTextFormat(Qt::RichText);
-    inputFormatLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    inputFormatView = new StatementView;
+    inputFormatView->setObjectName("formatLabel");
 
     inputBoxLayout->addLayout(inputHeader);
-    inputBoxLayout->addWidget(inputFormatLabel);
+    inputBoxLayout->addWidget(inputFormatView);
 
     // Output Format
     auto *outputBox = new QWidget;
@@ -194,14 +187,11 @@ void ProblemPanel::buildUI()
     outputHeader->addWidget(outputTitle);
     outputHeader->addStretch();
 
-    outputFormatLabel = new QLabel;
-    outputFormatLabel->setObjectName("formatLabel");
-    outputFormatLabel->setWordWrap(true);
-    outputFormatLabel->setTextFormat(Qt::RichText);
-    outputFormatLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    outputFormatView = new StatementView;
+    outputFormatView->setObjectName("formatLabel");
 
     outputBoxLayout->addLayout(outputHeader);
-    outputBoxLayout->addWidget(outputFormatLabel);
+    outputBoxLayout->addWidget(outputFormatView);
 
     formatLayout->addWidget(inputBox);
     formatLayout->addWidget(outputBox);
@@ -223,7 +213,14 @@ void ProblemPanel::buildUI()
     constraintsHeader->addWidget(constraintsTitle);
     constraintsHeader->addStretch();
 
+    constraintsList = new QWidget;
+    constraintsList->setObjectName("constraintsList");
+    auto *listLayout = new QVBoxLayout(constraintsList);
+    listLayout->setContentsMargins(16, 8, 0, 0);
+    listLayout->setSpacing(0);
+
     constraintsLayout->addLayout(constraintsHeader);
+    constraintsLayout->addWidget(constraintsList);
 
     // ═══════════════════════════════════════════════════════════════════
     // SAMPLE I/O SECTION
@@ -264,14 +261,11 @@ void ProblemPanel::buildUI()
     sampleInputHeaderLayout->addWidget(inputLabel);
     sampleInputHeaderLayout->addStretch();
 
-    sampleInputLabel = new QLabel;
-    sampleInputLabel->setObjectName("ioContent");
-    sampleInputLabel->setTextFormat(Qt::RichText);
-    sampleInputLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
-    sampleInputLabel->setWordWrap(true);
+    sampleInputView = new StatementView;
+    sampleInputView->setObjectName("ioContent");
 
     sampleInputBoxLayout->addWidget(sampleInputHeader);
-    sampleInputBoxLayout->addWidget(sampleInputLabel, 1);
+    sampleInputBoxLayout->addWidget(sampleInputView, 1);
 
     // Sample Output Box
     auto *sampleOutputBox = new QWidget;
@@ -289,28 +283,23 @@ void ProblemPanel::buildUI()
     sampleOutputHeaderLayout->addWidget(outputLabel);
     sampleOutputHeaderLayout->addStretch();
 
-    sampleOutputLabel = new QLabel;
-    sampleOutputLabel->setObjectName("ioContentOutput");
-    sampleOutputLabel->setTextFormat(Qt::RichText);
-    sampleOutputLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    sampleOutputView = new StatementView;
+    sampleOutputView->setObjectName("ioContentOutput");
 
     sampleOutputBoxLayout->addWidget(sampleOutputHeader);
-    sampleOutputBoxLayout->addWidget(sampleOutputLabel, 1);
+    sampleOutputBoxLayout->addWidget(sampleOutputView, 1);
 
     ioLayout->addWidget(sampleInputBox, 1);
     ioLayout->addWidget(sampleOutputBox, 1);
 
     // Explanation
-    sampleExplanationLabel = new QLabel;
-    sampleExplanationLabel->setObjectName("explanationLabel");
-    sampleExplanationLabel->setWordWrap(true);
-    sampleExplanationLabel->setTextFormat(Qt::RichText);
-    sampleExplanationLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
-    sampleExplanationLabel->setVisible(false);
+    sampleExplanationView = new StatementView;
+    sampleExplanationView->setObjectName("explanationLabel");
+    sampleExplanationView->setVisible(false);
 
     sampleLayout->addLayout(sampleHeader);
     sampleLayout->addWidget(ioContainer);
-    sampleLayout->addWidget(sampleExplanationLabel);
+    sampleLayout->addWidget(sampleExplanationView);
 
     // ═══════════════════════════════════════════════════════════════════
     // HINTS SECTION
@@ -387,6 +376,11 @@ QString ProblemPanel::buildStyleSheet()
             border: none;
         }
 
+        StatementView {
+            background: transparent;
+            border: none;
+        }
+
         #problemScrollArea QScrollBar:vertical {
             background: transparent;
             width: 8px;
@@ -471,6 +465,16 @@ QString ProblemPanel::buildStyleSheet()
             min-height: 28px;
         }
 
+        #tagChip {
+            background-color: hsla(90, 80%, 60%, 0.15);
+            color: hsl(90, 80%, 70%);
+            padding: 4px 10px;
+            border-radius: 6px;
+            font-size: 11px;
+            font-weight: 500;
+            border: 1px solid hsla(90, 80%, 60%, 0.15);
+        }
+
         /* ─── Section Titles ─── */
         #sectionTitle {
             font-size: 14px;
@@ -503,7 +507,7 @@ QString ProblemPanel::buildStyleSheet()
             color: #4ade80;
         }
 
-        #taskLabel {
+        #taskView {
             color: #9ca3af;
             font-size: 14px;
             line-height: 24px;
@@ -626,95 +630,21 @@ QString ProblemPanel::buildStyleSheet()
     )";
 }
 
-QString ProblemPanel::buildHtmlWrapper(const QString &content, const QString &additionalCss)
-{
-    // Base CSS for HTML content
-    QString baseCss = R"(
-        * { margin: 0; padding: 0; }
-        body {
-            font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif;
-            line-height: 1.7;
-            color: #aaa;
-        }
-        code {
-            background: #1a1a1a;
-            padding: 2px 7px;
-            border-radius: 4px;
-            color: #7dd3fc;
-            font-family: 'SF Mono', 'JetBrains Mono', monospace;
-            font-size: 0.9em;
-        }
-        strong, b { color: #ddd; font-weight: 600; }
-        em, i { color: #bbb; }
-
-        .io-line {
-            padding: 2px 0;
-            font-family: 'SF Mono', 'JetBrains Mono', monospace;
-        }
-        .io-line.comment {
-            color: #555;
-            font-style: italic;
-            font-size: 0.85em;
-        }
-        .io-line.highlight-green {
-            color: #4ade80;
-            font-weight: 600;
-        }
-        .io-line.highlight-red {
-            color: #f87171;
-            font-weight: 600;
-        }
-        .io-line.output {
-            color: #4ade80;
-        }
-
-        .input-table {
-            width: 100%;
-            border-collapse: collapse;
-        }
-        .input-table td {
-            padding: 6px 0;
-            vertical-align: top;
-        }
-        .input-table .line-num {
-            color: #666;
-            font-family: 'SF Mono', monospace;
-            font-size: 0.9em;
-            width: 100px;
-            padding-right: 12px;
-        }
-    )";
-
-    return QString("<html><head><style>%1 %2</style></head><body>%3</body></html>")
-        .arg(baseCss, additionalCss, content);
-}
-
-QString ProblemPanel::formatText(const QString &text)
+void ProblemPanel::loadFromJson(const QJsonObject &obj, const TestCases &tests)
 {
-    QString result = text;
-
-    // Replace \n with <br> for line breaks
-    result.replace("\\n", "<br>");
-    result.replace("\n", "<br>");
-
-    return result;
+    showStatement(*Statement::render(obj),
+                  tests ? tests : TestCaseSet::fromJson(obj["testCases"].toArray()));
 }
 
-void ProblemPanel::loadFromJson(const QJsonObject &obj)
+void ProblemPanel::showStatement(const Statement &statement, const TestCases &tests)
 {
     // ─── Store Problem Data ───
-    problemId = obj["id"].toString();
-    problemTitle = obj["title"].toString();
-    difficulty = obj["difficulty"].toString().toLower();
-    category = obj["category"].toString();
-
-    tags.clear();
-    QJsonArray tagsArray = obj["tags"].toArray();
-    for (const auto &tag : tagsArray) {
-        tags << tag.toString();
-    }
-
-    cachedTestCases = obj["testCases"].toArray();
+    problemId = statement.id;
+    problemTitle = statement.title;
+    difficulty = statement.difficulty.toLower();
+    category = statement.category;
+    tags = statement.tags;
+    testCases = tests;
 
     // ─── Update Header ───
     titleLabel->setText(problemTitle);
@@ -722,7 +652,7 @@ void ProblemPanel::loadFromJson(const QJsonObject &obj)
     categoryLabel->setText(category.isEmpty() ? "General" : category);
 
     // Difficulty badge
-    difficultyBadge->setText(obj["difficulty"].toString());
+    difficultyBadge->setText(statement.difficulty);
     difficultyBadge->setProperty("difficulty", difficulty);
     difficultyBadge->setAlignment(Qt::AlignCenter);
 
@@ -733,192 +663,82 @@ void ProblemPanel::loadFromJson(const QJsonObject &obj)
     difficultyBadge->style()->polish(difficultyBadge);
 
     // ─── Update Tags ───
-    QLayout *tagsLayout = tagsContainer->layout();
-    QLayoutItem *item;
-    while ((item = tagsLayout->takeAt(0)) != nullptr) {
-        delete item->widget();
-        delete item;
-    }
+    fillLabels(tagLabels, qobject_cast<QBoxLayout*>(tagsContainer->layout()), tags, "tagChip", false);
 
-    auto *tagsHLayout = qobject_cast<QHBoxLayout*>(tagsLayout);
-    for (const QString &tag : tags) {
-        auto *tagLabel = new QLabel(tag);
-        tagLabel->setStyleSheet(R"(
-            background-color: hsla(90, 80%, 60%, 0.15);
-            color: hsl(90, 80%, 70%);
-            padding: 4px 10px;
-            border-radius: 6px;
-            font-size: 11px;
-            font-weight: 500;
-            border: 1px solid hsla(90, 80%, 60%, 0.15);
-
-        )");
-        tagsHLayout->addWidget(tagLabel);
-    }
-    tagsHLayout->addStretch();
-
-    // ─── Update Description ───
-    QString descText = obj["description"].toString();
-    descriptionLabel->setText(buildHtmlWrapper(formatText(descText)));
-
-    // ─── Update Task ───
-    QString taskText = obj["task"].toString();
-    taskLabel->setText(buildHtmlWrapper(formatText(taskText), "body { color: #9ca3af; }"));
-
-    // ─── Update Input Format ───
-    QString inputText = obj["inputFormat"].toString();
-    inputFormatLabel->setText(buildHtmlWrapper(formatText(inputText), "body { color: #999; }"));
-
-    // ─── Update Output Format ───
-    QString outputText = obj["outputFormat"].toString();
-    outputFormatLabel->setText(buildHtmlWrapper(formatText(outputText), "body { color: #999; }"));
+    // ─── Update Sections ───
+    // The cached documents are shown as they are; nothing is parsed here
+    descriptionView->showDocument(statement.description);
+    taskView->showDocument(statement.task);
+    inputFormatView->showDocument(statement.inputFormat);
+    outputFormatView->showDocument(statement.outputFormat);
 
     // ─── Update Constraints ───
-    QJsonArray constraints = obj["constraints"].toArray();
-    QLayout *constraintsLayout = constraintsWidget->layout();
-
-    // Remove old items (keep header at index 0)
-    while (constraintsLayout->count() > 1) {
-        QLayoutItem *item = constraintsLayout->takeAt(1);
-        if (item->widget()) delete item->widget();
-        delete item;
-    }
-
-    if (constraints.isEmpty()) {
-        constraintsWidget->setVisible(false);
-    } else {
-        constraintsWidget->setVisible(true);
-
-        auto *constraintsList = new QWidget;
-        constraintsList->setObjectName("constraintsList");
-        auto *listLayout = new QVBoxLayout(constraintsList);
-        listLayout->setContentsMargins(16, 8, 0, 0);
-        listLayout->setSpacing(0);
-
-        for (const auto &constraint : constraints) {
-            auto *constraintLabel = new QLabel;
-            constraintLabel->setObjectName("constraintItem");
-            constraintLabel->setTextFormat(Qt::RichText);
-            constraintLabel->setText(QString("• %1").arg(constraint.toString()));
-            constraintLabel->setWordWrap(true);
-            listLayout->addWidget(constraintLabel);
-        }
-
-        qobject_cast<QVBoxLayout*>(constraintsLayout)->addWidget(constraintsList);
-    }
+    constraintsWidget->setVisible(!statement.constraints.isEmpty());
+    fillLabels(constraintLabels, qobject_cast<QBoxLayout*>(constraintsList->layout()),
+               statement.constraints, "constraintItem", true);
 
     // ─── Update Sample I/O ───
-    QString sampleInput = obj["sampleInput"].toString();
-    QString sampleOutput = obj["sampleOutput"].toString();
-    QString sampleExplanation = obj["sampleExplanation"].toString();
-
-    // Build I/O HTML
-    QString ioCss = R"(
-        body {
-            font-family: 'SF Mono', 'JetBrains Mono', monospace;
-            font-size: 13px;
-            line-height: 1.7;
-        }
-        .io-line { padding: 1px 0; }
-        .io-line.comment { color: #555; font-style: italic; font-size: 0.9em; }
-        .io-line.highlight-green {
-            display: inline-block;
-            background: rgba(74, 222, 128, 0.15);
-            color: #4ade80;
-            padding: 2px 8px;
-            border-radius: 4px;
-            font-weight: 600;
-        }
-        .io-line.highlight-red {
-            display: inline-block;
-            background: rgba(248, 113, 113, 0.15);
-            color: #f87171;
-            padding: 2px 8px;
-            border-radius: 4px;
-            font-weight: 600;
-        }
-        .io-line.output { color: #4ade80; }
-    )";
-
-    sampleInputLabel->setText(buildHtmlWrapper(sampleInput, ioCss + " body { color: #7dd3fc; }"));
-    sampleOutputLabel->setText(buildHtmlWrapper(sampleOutput, ioCss + " body { color: #4ade80; }"));
-
-    // Explanation
-    if (sampleExplanation.isEmpty()) {
-        sampleExplanationLabel->setVisible(false);
-    } else {
-        sampleExplanationLabel->setVisible(true);
-        QString explainCss = "body { color: #888; } code { background: #1a1a1a; color: #7dd3fc; }";
-        sampleExplanationLabel->setText(buildHtmlWrapper(
-            QString("💡 %1").arg(formatText(sampleExplanation)),
-            explainCss
-            ));
-    }
+    sampleInputView->showDocument(statement.sampleInput);
+    sampleOutputView->showDocument(statement.sampleOutput);
+    sampleExplanationView->setVisible(!statement.sampleExplanation.isNull());
+    sampleExplanationView->showDocument(statement.sampleExplanation);
 
     // ─── Update Hints ───
-    QJsonArray hints = obj["hints"].toArray();
-
-    if (hints.isEmpty()) {
-        hintsWidget->setVisible(false);
-    } else {
-        hintsWidget->setVisible(true);
-        hintsToggle->setChecked(false);
-        hintsContent->setVisible(false);
-
-        QLayout *hintsContentLayout = hintsContent->layout();
-
-        QLayoutItem *hintItem;
-        while ((hintItem = hintsContentLayout->takeAt(0)) != nullptr) {
-            if (hintItem->widget()) delete hintItem->widget();
-            delete hintItem;
-        }
-
-        int hintNum = 1;
-        for (const auto &hint : hints) {
-            auto *hintLabel = new QLabel;
-            hintLabel->setObjectName("hintItem");
-            hintLabel->setWordWrap(true);
-            hintLabel->setTextFormat(Qt::RichText);
-            hintLabel->setText(QString("<span style='color:#60a5fa;font-weight:600;'>%1.</span> %2")
-                                   .arg(hintNum++)
-                                   .arg(hint.toString()));
-            qobject_cast<QVBoxLayout*>(hintsContentLayout)->addWidget(hintLabel);
-        }
-    }
+    hintsWidget->setVisible(!statement.hints.isEmpty());
+    hintsToggle->setChecked(false);
+    hintsContent->setVisible(false);
+    fillLabels(hintLabels, qobject_cast<QBoxLayout*>(hintsContent->layout()),
+               statement.hints, "hintItem", true);
 
     // ─── Emit Signals ───
     emit problemLoaded(problemId);
-    emit testCasesAvailable(cachedTestCases);
+    emit testCasesAvailable(testCases);
 }
 
-bool ProblemPanel::loadFromFile(const QString &filePath)
+void ProblemPanel::fillLabels(QList<QLabel*> &labels, QBoxLayout *layout, const QStringList &texts,
+                              const QString &objectName, bool richText)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Could not open file:" << filePath;
-        return false;
+    // Styled by the panel's stylesheet through their object name; a style
+    // sheet of their own would be parsed again for every label
+    while (labels.size() < texts.size()) {
+        auto *label = new QLabel;
+        label->setObjectName(objectName);
+        label->setTextFormat(richText ? Qt::RichText : Qt::PlainText);
+        label->setWordWrap(richText);
+        layout->insertWidget(int(labels.size()), label);
+        labels.append(label);
     }
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
-
-    if (error.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << error.errorString();
-        return false;
+    for (int i = 0; i < labels.size(); ++i) {
+        const bool used = i < texts.size();
+        if (used && labels[i]->text() != texts[i]) labels[i]->setText(texts[i]);
+        labels[i]->setVisible(used);
     }
+}
 
-    if (!doc.isObject()) {
-        qWarning() << "JSON root is not an object";
+bool ProblemPanel::loadFromFile(const QString &filePath)
+{
+    // Parsed once by the repository; reopening a problem is a cache hit
+    const ProblemRepository::Problem problem = repository->problem(filePath);
+    if (!problem.isValid()) {
         return false;
     }
 
-    loadFromJson(doc.object());
+    // Rendered once per version of the file, or already by prefetch()
+    showStatement(*statements->get(problem.contentHash, problem.root), problem.tests);
     return true;
 }
 
+void ProblemPanel::prefetch(const QString &filePath)
+{
+    statements->prefetch(filePath);
+}
+
+void ProblemPanel::stopPrefetching()
+{
+    statements->stop();
+}
+
 void ProblemPanel::paintEvent(QPaintEvent *event)
 {
     QStyleOption opt;
@@ -7,24 +7,36 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QPushButton>
+#include "statement_cache.h"
+#include "test_case_set.h"
+
+class ProblemRepository;
+class QBoxLayout;
+class StatementView;
 
 class ProblemPanel : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ProblemPanel(QWidget *parent = nullptr);
+    explicit ProblemPanel(ProblemRepository *repo, QWidget *parent = nullptr);
 
-    void loadFromJson(const QJsonObject &obj);
+    // Tests come from obj["testCases"] unless given already parsed
+    void loadFromJson(const QJsonObject &obj, const TestCases &tests = {});
     bool loadFromFile(const QString &filePath);
+    // Renders a problem's statement in the background, e.g. the next one
+    // in the browser, so opening it only swaps documents into the views
+    void prefetch(const QString &filePath);
+    // Ends background rendering; call before the repository goes away
+    void stopPrefetching();
 
     QString getProblemId() const { return problemId; }
     QString getTitle() const { return problemTitle; }
     QString getDifficulty() const { return difficulty; }
-    QJsonArray getTestCases() const { return cachedTestCases; }
+    TestCases getTestCases() const { return testCases; }
 
 signals:
     void problemLoaded(const QString &problemId);
-    void testCasesAvailable(const QJsonArray &testCases);
+    void testCasesAvailable(const TestCases &testCases);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -32,8 +44,10 @@ protected:
 private:
     void buildUI();
     QString buildStyleSheet();
-    QString buildHtmlWrapper(const QString &content, const QString &additionalCss = "");
-    QString formatText(const QString &text);
+    void showStatement(const Statement &statement, const TestCases &tests);
+    // One label per text, reusing the labels of earlier problems
+    void fillLabels(QList<QLabel*> &labels, QBoxLayout *layout, const QStringList &texts,
+                    const QString &objectName, bool richText);
 
     QScrollArea *scrollArea;
     QWidget *contentWidget;
@@ -44,23 +58,27 @@ private:
     QLabel *difficultyBadge;
     QLabel *categoryLabel;
     QWidget *tagsContainer;
+    QList<QLabel*> tagLabels;
 
     // Content sections
-    QLabel *descriptionLabel;
-    QLabel *taskLabel;
-    QLabel *inputFormatLabel;
-    QLabel *outputFormatLabel;
+    StatementView *descriptionView;
+    StatementView *taskView;
+    StatementView *inputFormatView;
+    StatementView *outputFormatView;
     QWidget *constraintsWidget;
+    QWidget *constraintsList;
+    QList<QLabel*> constraintLabels;
 
     // Sample I/O
-    QLabel *sampleInputLabel;
-    QLabel *sampleOutputLabel;
-    QLabel *sampleExplanationLabel;
+    StatementView *sampleInputView;
+    StatementView *sampleOutputView;
+    StatementView *sampleExplanationView;
 
     // Hints
     QWidget *hintsWidget;
     QWidget *hintsContent;
     QPushButton *hintsToggle;
+    QList<QLabel*> hintLabels;
 
     // Problem data
     QString problemId;
@@ -69,7 +87,10 @@ private:
     QString category;
     QStringList tags;
 
-    QJsonArray cachedTestCases;
+    TestCases testCases;   // Shared with the repository's cache
+
+    ProblemRepository *repository;
+    StatementCache *statements;
 };
 
 #endif // PROBLEM_PANEL_H
@@ -0,0 +1,79 @@
+#include "problem_path_resolver.h"
+#include "problem_repository.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+
+ProblemPathResolver::ProblemPathResolver(const ProblemRepository *repository)
+    : m_repository(repository) {
+}
+
+void ProblemPathResolver::invalidate() {
+    QMutexLocker lock(&m_mutex);
+    m_built = false;
+    m_byId.clear();
+}
+
+QString ProblemPathResolver::resolve(const QString &problem) {
+    if (problem.isEmpty()) return QString();
+
+    QMutexLocker lock(&m_mutex);
+    if (!m_built) buildIdMap();
+    QString path = lookup(problem);
+    if (path.isEmpty()) path = probe(problem);
+
+    if (path.isEmpty()) {
+        qDebug() << "Could not find problem file for:" << problem;
+    }
+    return path;
+}
+
+void ProblemPathResolver::buildIdMap() {
+    const CatalogIndex &catalog = m_repository->catalog();
+    const QDir base(m_repository->problemsDir());
+    m_byId.reserve(catalog.size() * 2);
+    for (int i = 0; i < catalog.size(); ++i) {
+        const QString path = QDir::cleanPath(base.absoluteFilePath(catalog.path(i)));
+        m_byId.insert(catalog.id(i), path);
+        // Progress and solutions are keyed by the file's base name
+        m_byId.insert(QFileInfo(path).completeBaseName(), path);
+    }
+    m_built = true;
+}
+
+QString ProblemPathResolver::lookup(const QString &problem) const {
+    auto it = m_byId.constFind(problem);
+    if (it != m_byId.constEnd()) return *it;
+
+    if (m_repository->exists(problem)) return problem;
+
+    // Relative to the problems directory, as problems.json lists them
+    const QString relative = QDir::cleanPath(QDir(m_repository->problemsDir()).absoluteFilePath(problem));
+    if (m_repository->exists(relative)) return relative;
+    return QString();
+}
+
+QString ProblemPathResolver::probe(const QString &problem) const {
+    // Problems outside the catalog, e.g. a checkout's data/problems
+    const QStringList relPaths = {
+        "/data/problems/" + problem + ".json",
+        "/problems/" + problem + ".json",
+        "/problems/easy/" + problem + ".json",
+        "/problems/medium/" + problem + ".json",
+        "/problems/hard/" + problem + ".json",
+    };
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QStringList basePaths = {
+        QDir::currentPath(), appDir, appDir + "/..", appDir + "/../..", appDir + "/../../..",
+    };
+
+    for (const QString &base : basePaths) {
+        for (const QString &rel : relPaths) {
+            const QString full = QDir::cleanPath(base + rel);
+            if (QFileInfo::exists(full)) return full;
+        }
+    }
+    return QString();
+}
@@ -0,0 +1,35 @@
+#ifndef PROBLEM_PATH_RESOLVER_H
+#define PROBLEM_PATH_RESOLVER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+class ProblemRepository;
+
+// Turns whatever names a problem (a full path, a path relative to the
+// problems directory, a catalog id or a file's base name) into the path of
+// its file. The id map is built once from the catalog, so looking up an id
+// is a hash probe; invalidate() drops it when the problem files change.
+// Paths and names outside the catalog are checked on the file system every
+// time, so a file created later is found and a deleted one is not.
+class ProblemPathResolver {
+public:
+    explicit ProblemPathResolver(const ProblemRepository *repository);
+
+    // Empty if nothing matches
+    QString resolve(const QString &problem);
+    void invalidate();
+
+private:
+    void buildIdMap();
+    QString lookup(const QString &problem) const;
+    QString probe(const QString &problem) const;
+
+    const ProblemRepository *m_repository;
+    QMutex m_mutex;
+    bool m_built = false;
+    QHash<QString, QString> m_byId;   // Catalog id and file base name -> path
+};
+
+#endif // PROBLEM_PATH_RESOLVER_H
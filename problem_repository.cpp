@@ -0,0 +1,297 @@
+#include "problem_repository.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+// Parsed JSON costs a few times the file size; this holds the recently
+// opened problems, not the whole catalog
+constexpr qint64 DefaultCacheBytes = 32LL * 1024 * 1024;
+
+// Quiet period before a burst of file changes is applied
+constexpr int ReloadDebounceMs = 300;
+
+// QCache counts cost in qsizetype; keep the file size as-is
+qsizetype costOf(qint64 fileSize) {
+    return qsizetype(qMax<qint64>(1, fileSize));
+}
+
+} // namespace
+
+ProblemRepository::ProblemRepository(QObject *parent)
+    : QObject(parent), resolver(this), watcher(new QFileSystemWatcher(this))
+{
+    cache.setMaxCost(qsizetype(DefaultCacheBytes));
+
+    reloadTimer.setSingleShot(true);
+    reloadTimer.setInterval(ReloadDebounceMs);
+    connect(&reloadTimer, &QTimer::timeout, this, &ProblemRepository::reload);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &ProblemRepository::onFileChanged);
+    connect(watcher, &QFileSystemWatcher::directoryChanged,
+            this, &ProblemRepository::onDirectoryChanged);
+}
+
+bool ProblemRepository::openPack(const QString &packPath)
+{
+    auto opened = QSharedPointer<ProblemPack>::create();
+    if (!opened->open(QDir::cleanPath(QFileInfo(packPath).absoluteFilePath()))) {
+        qWarning() << "Failed to open problem pack:" << packPath;
+        return false;
+    }
+
+    // The catalog index is stored raw and used straight from the mapping.
+    // It is checked before anything is switched over, so a bad pack leaves
+    // the current catalog and pack in use.
+    const QByteArrayView index = opened->rawView(ProblemPack::IndexName);
+    const uchar *indexData = reinterpret_cast<const uchar *>(index.data());
+    {
+        CatalogIndex probe;
+        if (!probe.openData(indexData, index.size())) {
+            qWarning() << "Problem pack has no usable catalog index:" << packPath;
+            return false;
+        }
+    }
+
+    resolver.invalidate();
+    if (!catalogIndex.openData(indexData, index.size())) {
+        problemPack.reset();
+        return false;
+    }
+    problemPack = opened;
+    const QString root = problemPack->fileName() + '/';
+    catalogFile = root + ProblemPack::CatalogName;
+    baseDir = root + ProblemPack::ProblemsDir;
+    qDebug() << "Problem catalog:" << catalogIndex.size() << "problems from" << packPath;
+    return true;
+}
+
+QString ProblemRepository::packEntry(const QString &filePath) const
+{
+    const QString root = problemPack->fileName() + '/';
+    const QString path = QDir::cleanPath(QFileInfo(filePath).absoluteFilePath());
+    return path.startsWith(root) ? path.mid(root.size()) : QString();
+}
+
+QByteArray ProblemRepository::readFile(const QString &filePath) const
+{
+    if (problemPack) return problemPack->read(packEntry(filePath));
+
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+bool ProblemRepository::exists(const QString &filePath) const
+{
+    if (problemPack) return problemPack->contains(packEntry(filePath));
+    return QFile::exists(filePath);
+}
+
+bool ProblemRepository::open(const QString &catalogPath, const QString &problemsDir)
+{
+    catalogFile = QFileInfo(catalogPath).absoluteFilePath();
+    baseDir = problemsDir;
+    lastReload = QDateTime::currentDateTime();
+    resolver.invalidate();
+    watch();
+
+    if (!catalogIndex.open(catalogPath, problemsDir)) {
+        qWarning() << "Failed to load problem catalog:" << catalogPath;
+        return false;
+    }
+    qDebug() << "Problem catalog:" << catalogIndex.size() << "problems";
+    return true;
+}
+
+void ProblemRepository::watch()
+{
+    // The directories and problems.json only, not one watch per problem
+    // file. A problem file saved in place is caught by problem() instead,
+    // which checks the file's time and then its record. Paths replaced by a
+    // rename drop out of the watcher and come back here.
+    QStringList paths = {catalogFile, QFileInfo(baseDir).absoluteFilePath()};
+    QDirIterator it(baseDir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) paths << it.nextFileInfo().absoluteFilePath();
+
+    const QStringList files = watcher->files();
+    const QStringList dirs = watcher->directories();
+    QSet<QString> watched(files.begin(), files.end());
+    watched.unite(QSet<QString>(dirs.begin(), dirs.end()));
+    QStringList added;
+    for (const QString &path : paths) {
+        if (!watched.contains(path) && QFileInfo::exists(path)) {
+            added << path;
+        }
+    }
+    if (!added.isEmpty()) watcher->addPaths(added);
+}
+
+void ProblemRepository::onFileChanged(const QString &path)
+{
+    if (path == catalogFile) {
+        catalogTouched = true;
+    } else {
+        changedFiles.insert(QDir::cleanPath(path));
+    }
+    reloadTimer.start();
+}
+
+void ProblemRepository::onDirectoryChanged(const QString &path)
+{
+    // Something was added, removed or renamed here; files written since the
+    // last reload are the candidates
+    QDirIterator it(path, {"*.json"}, QDir::Files);
+    while (it.hasNext()) {
+        const QFileInfo info = it.nextFileInfo();
+        if (info.lastModified() >= lastReload) {
+            changedFiles.insert(QDir::cleanPath(info.absoluteFilePath()));
+        }
+    }
+    reloadTimer.start();
+}
+
+void ProblemRepository::reload()
+{
+    const QSet<QString> changed = std::exchange(changedFiles, {});
+    const bool touched = std::exchange(catalogTouched, false);
+    lastReload = QDateTime::currentDateTime();
+
+    const quint64 before = catalogIndex.contentHash();
+    const int beforeSize = catalogIndex.size();
+    catalogIndex.refresh(changed);
+    resolver.invalidate();
+
+    for (const QString &path : changed) {
+        invalidate(path);
+        emit problemChanged(path);
+    }
+    if (touched || catalogIndex.contentHash() != before || catalogIndex.size() != beforeSize) {
+        qDebug() << "Problem catalog reloaded:" << changed.size() << "changed files";
+        emit catalogChanged();
+    }
+
+    watch();
+}
+
+ProblemRepository::Problem ProblemRepository::problem(const QString &filePath, bool withTests)
+{
+    const QFileInfo info(filePath);
+    const QString key = info.absoluteFilePath();
+    const qint64 size = info.size();
+    const QDateTime modified = info.lastModified();
+
+    {
+        QMutexLocker lock(&mutex);
+        if (Cached *cached = cache.object(key)) {
+            if (cached->size == size && cached->modified == modified) {
+                Problem result = cached->problem;
+                if (!withTests) return result;
+                // Nobody held on to the tests: parsed again below
+                result.tests = liveSet(key, result.contentHash);
+                if (result.tests) return result;
+            } else {
+                cache.remove(key);
+            }
+        }
+    }
+
+    // Parsed outside the lock; a racing caller at worst parses it twice
+    const QByteArray bytes = readFile(key);
+    if (bytes.isEmpty()) {
+        qWarning() << "Could not open problem file:" << filePath;
+        return Problem();
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(bytes, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "Invalid problem file:" << filePath << error.errorString();
+        return Problem();
+    }
+
+    // The tests are only kept as the set's bytes, not again as JSON
+    auto *cached = new Cached;
+    cached->problem.root = doc.object();
+    const QJsonArray tests = cached->problem.root.take("testCases").toArray();
+    cached->problem.filePath = key;
+    cached->problem.contentHash = CatalogIndex::hash(bytes);
+    cached->size = size;
+    cached->modified = modified;
+    Problem result = cached->problem;
+
+    // A set still in use for this version is handed out again rather than
+    // built a second time
+    if (withTests) {
+        {
+            QMutexLocker lock(&mutex);
+            result.tests = liveSet(key, result.contentHash);
+        }
+        if (!result.tests) {
+            result.tests = TestCaseSet::fromJson(tests);
+            QMutexLocker lock(&mutex);
+            liveTests.insert(key, {result.contentHash, result.tests.toWeakRef()});
+        }
+    }
+
+    // Only the statement counts against the budget; the file size would
+    // charge it for the tests as well
+    const qint64 statementBytes = QJsonDocument(cached->problem.root).toJson(QJsonDocument::Compact).size();
+
+    // Edited while the app was not running: the index still has the old
+    // version, and its fingerprint only notices changed directories
+    if (!problemPack) {
+        const quint64 contentHash = result.contentHash;
+        QMetaObject::invokeMethod(this, [this, key, contentHash]() { checkIndexed(key, contentHash); });
+    }
+
+    QMutexLocker lock(&mutex);
+    // Larger than the whole budget: QCache deletes it right away, the
+    // caller still gets its copy
+    cache.insert(key, cached, costOf(statementBytes));
+    return result;
+}
+
+TestCases ProblemRepository::liveSet(const QString &filePath, quint64 contentHash)
+{
+    auto it = liveTests.find(filePath);
+    if (it == liveTests.end()) return TestCases();
+    if (it->contentHash == contentHash) {
+        if (TestCases tests = it->tests.toStrongRef()) return tests;
+    }
+    liveTests.erase(it);
+    return TestCases();
+}
+
+void ProblemRepository::checkIndexed(const QString &filePath, quint64 contentHash)
+{
+    if (problemPack) return;
+    const QString path = QDir(baseDir).relativeFilePath(filePath);
+    for (int i = 0; i < catalogIndex.size(); ++i) {
+        if (catalogIndex.path(i) != path) continue;
+        if (catalogIndex.contentHash(i) != contentHash) {
+            changedFiles.insert(QDir::cleanPath(filePath));
+            reloadTimer.start();
+        }
+        return;
+    }
+}
+
+void ProblemRepository::invalidate(const QString &filePath)
+{
+    QMutexLocker lock(&mutex);
+    const QString key = QFileInfo(filePath).absoluteFilePath();
+    cache.remove(key);
+    liveTests.remove(key);
+}
+
+void ProblemRepository::setCacheLimit(qint64 bytes)
+{
+    QMutexLocker lock(&mutex);
+    cache.setMaxCost(costOf(bytes));
+}
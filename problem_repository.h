@@ -0,0 +1,125 @@
+#ifndef PROBLEM_REPOSITORY_H
+#define PROBLEM_REPOSITORY_H
+
+#include "catalog_index.h"
+#include "problem_pack.h"
+#include "problem_path_resolver.h"
+#include "test_case_set.h"
+#include <QObject>
+#include <QCache>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
+
+class QFileSystemWatcher;
+
+// Single place the app reads problems from. Catalog metadata is loaded
+// eagerly through the mapped CatalogIndex; a problem file is only parsed
+// when its statement or tests are first asked for, and the parsed
+// statements stay in an LRU cache bounded by their size in bytes. The tests
+// are split off into a TestCaseSet, so everyone running or showing them
+// shares one copy. Sets are not in the LRU: they live as long as someone
+// holds them, and the repository hands out the live one for as long as the
+// file is unchanged, however large it is.
+//
+// problems.json and the problem directories are watched while the app runs;
+// a problem file saved in place is noticed the next time it is parsed.
+// Bursts of changes (an editor saving, a checkout) are collected and
+// applied together once they settle: only the changed files are read
+// again, and listeners are told what changed.
+//
+// The problems can also come from a .sfpack instead of loose files. Paths
+// then live under the pack's own path ("<pack>/problems/easy/x.json"), so
+// the rest of the app handles them the same way; packs are not watched.
+class ProblemRepository : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Problem {
+        QJsonObject root;      // The problem file without its "testCases"
+        TestCases tests;       // One set per version of the file; null if invalid
+        QString filePath;
+        quint64 contentHash = 0;   // CatalogIndex::hash of the file
+        bool isValid() const { return !filePath.isEmpty(); }
+    };
+
+    explicit ProblemRepository(QObject *parent = nullptr);
+
+    bool open(const QString &catalogPath, const QString &problemsDir);
+    bool openPack(const QString &packPath);
+    const CatalogIndex &catalog() const { return catalogIndex; }
+    QString problemsDir() const { return baseDir; }
+    QSharedPointer<const ProblemPack> pack() const { return problemPack; }
+
+    // Path of a problem given its path, catalog id or file base name
+    QString resolve(const QString &problem) { return resolver.resolve(problem); }
+
+    // Raw contents of a problem file, from the pack when one is open
+    QByteArray readFile(const QString &filePath) const;
+    bool exists(const QString &filePath) const;
+
+    // Parsed problem file; served from the cache unless the file changed
+    // on disk since it was parsed. Without withTests, tests is left null and
+    // no set is built for it. Safe to call from any thread.
+    Problem problem(const QString &filePath, bool withTests = true);
+    QJsonObject statement(const QString &filePath) { return problem(filePath, false).root; }
+    TestCases tests(const QString &filePath) { return problem(filePath).tests; }
+
+    void invalidate(const QString &filePath);
+    void setCacheLimit(qint64 bytes);
+
+signals:
+    // The catalog index was rebuilt with different contents
+    void catalogChanged();
+    // A problem file was edited, added or removed (absolute path)
+    void problemChanged(const QString &filePath);
+
+private slots:
+    void onFileChanged(const QString &path);
+    void onDirectoryChanged(const QString &path);
+    void reload();
+
+private:
+    void watch();
+    // Queues a reload of filePath when the catalog index has another version
+    void checkIndexed(const QString &filePath, quint64 contentHash);
+
+    struct Cached {
+        Problem problem;       // Without its tests, see liveTests
+        qint64 size = 0;
+        QDateTime modified;
+    };
+
+    // The set of filePath's version contentHash if someone still holds it
+    TestCases liveSet(const QString &filePath, quint64 contentHash);
+
+    QString packEntry(const QString &filePath) const;
+
+    QSharedPointer<ProblemPack> problemPack;   // Outlives catalogIndex's view of it
+    CatalogIndex catalogIndex;
+    QString catalogFile;
+    QString baseDir;
+
+    ProblemPathResolver resolver;
+
+    QFileSystemWatcher *watcher;
+    QTimer reloadTimer;
+    QSet<QString> changedFiles;   // Since the last reload
+    bool catalogTouched = false;
+    QDateTime lastReload;
+
+    QMutex mutex;
+    QCache<QString, Cached> cache;   // Keyed by absolute path, cost in bytes
+    struct LiveTests {
+        quint64 contentHash = 0;
+        QWeakPointer<const TestCaseSet> tests;
+    };
+    QHash<QString, LiveTests> liveTests;   // Keyed like cache, guarded by mutex
+};
+
+#endif // PROBLEM_REPOSITORY_H
@@ -198,13 +198,65 @@ QColor ProblemCard::getDifficultyColor(const QString &diff) {
 // ==========================================
 // PROBLEM BROWSER
 // ==========================================
-ProblemBrowser::ProblemBrowser(ProgressManager *pm, QWidget *parent)
+namespace {
+constexpr int FirstCards = 40;   // About a screenful
+constexpr int CardBatch = 100;
+}
+
+ProblemBrowser::ProblemBrowser(ProgressManager *pm, ProblemRepository *repo, QWidget *parent)
     : QWidget(parent),
-    progressManager(pm)   // ✅ STORE IT HERE
+    progressManager(pm),   // ✅ STORE IT HERE
+    repository(repo)
 {
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->setContentsMargins(0, 0, 0, 0);
     progressManager->load();
+
+    // SEARCH BAR
+    // Same flat, square look as the cards; filters as you type
+    QWidget *searchBar = new QWidget(this);
+    searchBar->setStyleSheet("background-color: #0f0f0f;");
+    QHBoxLayout *searchLayout = new QHBoxLayout(searchBar);
+    searchLayout->setContentsMargins(20, 20, 20, 0);
+
+    searchBox = new QLineEdit(searchBar);
+    searchBox->setPlaceholderText("Search problems, topics, statements...");
+    searchBox->setClearButtonEnabled(true);
+    searchBox->setStyleSheet(R"(
+        QLineEdit {
+            background-color: #161616;
+            color: #eeeeee;
+            border: 1px solid #2a2a2a;
+            border-radius: 0px;
+            padding: 8px 12px;
+            font-family: 'Consolas', monospace;
+            font-size: 13px;
+        }
+        QLineEdit:focus {
+            border-color: #444444;
+        }
+    )");
+    searchLayout->addWidget(searchBox, 1);
+
+    // FACETS
+    // Difficulty x topic x status, and the order the matches are listed in
+    difficultyFilter = addFilter(searchLayout);
+    topicFilter = addFilter(searchLayout);
+    statusFilter = addFilter(searchLayout);
+    statusFilter->addItem("Any status", ProblemFacets::AnyStatus);
+    statusFilter->addItem("Solved", ProblemFacets::Solved);
+    statusFilter->addItem("Unsolved", ProblemFacets::Unsolved);
+    statusFilter->addItem("Starred", ProblemFacets::Starred);
+    sortOrder = addFilter(searchLayout);
+    sortOrder->addItem("Catalog order", ProblemFacets::CatalogOrder);
+    sortOrder->addItem("Most attempts", ProblemFacets::MostAttempts);
+    sortOrder->addItem("Recently solved", ProblemFacets::RecentlySolved);
+    for (QComboBox *combo : {difficultyFilter, topicFilter, statusFilter, sortOrder}) {
+        connect(combo, &QComboBox::currentIndexChanged, this, &ProblemBrowser::applyFilters);
+    }
+
+    mainLayout->addWidget(searchBar);
+
     QScrollArea *scrollArea = new QScrollArea(this);
     scrollArea->setWidgetResizable(true);
 
@@ -246,51 +298,193 @@ ProblemBrowser::ProblemBrowser(ProgressManager *pm, QWidget *parent)
     connect(progressManager, &ProgressManager::progressChanged,
             this, &ProblemBrowser::onProgressChanged);
 
+    // The rest of the cards are made while the UI is idle
+    cardTimer.setInterval(0);
+    connect(&cardTimer, &QTimer::timeout, this, [this]() {
+        addCards(CardBatch);
+    });
+
+    // Edited problems: the search index only re-reads what changed
+    connect(repository, &ProblemRepository::catalogChanged, this, &ProblemBrowser::loadCatalog);
+
+    searchIndex = new SearchIndex(this);
+    connect(searchBox, &QLineEdit::textChanged, this, &ProblemBrowser::applyFilters);
+    connect(searchIndex, &SearchIndex::ready, this, [this]() {
+        if (!searchBox->text().trimmed().isEmpty()) applyFilters();
+    });
+
 
 }
 
-// Logic loadFromJson remains the same as requested...
-void ProblemBrowser::loadFromJson(const QString &filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) return;
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    QJsonArray array = doc.array();
+// Cards are made from the repository's catalog index, the first screenful
+// right away
+void ProblemBrowser::loadCatalog() {
+    cardTimer.stop();
     cardMap.clear();
+    shown.clear();
+    nextCard = 0;
 
     // Clear old widgets
     QLayoutItem *child;
     while ((child = listLayout->takeAt(0)) != nullptr) {
-        delete child->widget();
         delete child;
     }
+    qDeleteAll(cards);
+    cards = QList<ProblemCard*>(repository->catalog().size(), nullptr);
+
+    const CatalogIndex &catalog = repository->catalog();
+    facets.build(catalog, progressManager);
+
+    // Facet choices come from the catalog; keep the current ones if they still exist
+    auto fill = [](QComboBox *combo, const QString &any, const QStringList &names) {
+        const QString current = combo->currentText();
+        QSignalBlocker block(combo);
+        combo->clear();
+        combo->addItem(any, -1);
+        for (int i = 0; i < names.size(); ++i) combo->addItem(names[i], i);
+        combo->setCurrentIndex(qMax(0, combo->findText(current)));
+    };
+    fill(difficultyFilter, "Any difficulty", catalog.difficulties());
+    fill(topicFilter, "Any topic", catalog.topics());
+
+    searchIndex->rebuild(catalog, repository->problemsDir(), repository->pack());
+    applyFilters();
+}
 
-    for (const QJsonValue &val : array) {
-        QJsonObject obj = val.toObject();
-        ProblemData data;
-        data.id = obj["id"].toString();
-        data.title = obj["title"].toString();
-        data.difficulty = obj["difficulty"].toString();
-        data.path = obj["path"].toString();
-        QJsonObject statusObj = obj["status"].toObject();
-        // data.isSolved = statusObj["solved"].toBool(); this change from this to
-        data.isSolved = progressManager->isSolved(data.id);
-        QJsonArray topicArray = obj["topics"].toArray();
-        for (const QJsonValue &t : topicArray) data.topics.append(t.toString());
+QComboBox *ProblemBrowser::addFilter(QHBoxLayout *layout) {
+    QComboBox *combo = new QComboBox(this);
+    combo->setCursor(Qt::PointingHandCursor);
+    combo->setStyleSheet(R"(
+        QComboBox {
+            background-color: #161616;
+            color: #999999;
+            border: 1px solid #2a2a2a;
+            border-radius: 0px;
+            padding: 7px 10px;
+            font-family: 'Consolas', monospace;
+            font-size: 12px;
+        }
+        QComboBox:hover {
+            color: #ffffff;
+            border-color: #444444;
+        }
+        QComboBox::drop-down { border: none; }
+        QComboBox QAbstractItemView {
+            background-color: #161616;
+            color: #cccccc;
+            selection-background-color: #2a2a2a;
+            border: 1px solid #2a2a2a;
+        }
+    )");
+    layout->addWidget(combo);
+    return combo;
+}
+
+ProblemFacets::Filter ProblemBrowser::currentFilter() const {
+    ProblemFacets::Filter filter;
+    const int difficulty = difficultyFilter->currentData().toInt();
+    if (difficulty >= 0) filter.difficulties.insert(difficulty);
+    const int topic = topicFilter->currentData().toInt();
+    if (topic >= 0) filter.topics.insert(topic);
+    filter.status = ProblemFacets::Status(statusFilter->currentData().toInt());
+    filter.sort = ProblemFacets::Sort(sortOrder->currentData().toInt());
+    return filter;
+}
+
+void ProblemBrowser::applyFilters() {
+    const QString query = searchBox->text().trimmed();
+    const CatalogIndex &catalog = repository->catalog();
+
+    QList<int> indexes;
+    if (query.isEmpty()) {
+        indexes.reserve(catalog.size());
+        for (int i = 0; i < catalog.size(); ++i) indexes.append(i);
+    } else if (searchIndex->isReady()) {
+        indexes = searchIndex->search(query);
+    } else {
+        // Index still building: titles only until it is ready
+        for (int i = 0; i < catalog.size(); ++i) {
+            if (catalog.entry(i).title.contains(query, Qt::CaseInsensitive)) indexes.append(i);
+        }
+    }
+    showProblems(facets.apply(currentFilter(), indexes));
+}
+
+void ProblemBrowser::showProblems(const QList<int> &indexes) {
+    cardTimer.stop();
+
+    // Cards stay alive when filtered out; only the layout is redone
+    QLayoutItem *child;
+    while ((child = listLayout->takeAt(0)) != nullptr) {
+        delete child;
+    }
+    for (int i = 0; i < nextCard; ++i) {
+        if (shown[i] < cards.size() && cards[shown[i]]) cards[shown[i]]->hide();
+    }
+
+    shown = indexes;
+    nextCard = 0;
+    addCards(FirstCards);
+}
+
+QString ProblemBrowser::pathAfter(const QString &problemPath) const {
+    const CatalogIndex &catalog = repository->catalog();
+    for (qsizetype i = 0; i + 1 < shown.size(); ++i) {
+        if (catalog.path(shown[i]) == problemPath) return catalog.path(shown[i + 1]);
+    }
+    return QString();
+}
+
+ProblemCard *ProblemBrowser::cardFor(int index) {
+    if (index < 0 || index >= cards.size()) return nullptr;
+    if (cards[index]) return cards[index];
 
-        ProblemCard *card = new ProblemCard(data, scrollContent);
+    const CatalogIndex::Entry entry = repository->catalog().entry(index);
+    ProblemData data;
+    data.id = entry.id;
+    data.title = entry.title;
+    data.difficulty = entry.difficulty;
+    data.path = entry.path;
+    data.topics = entry.topics;
+    data.isSolved = progressManager->isSolved(data.id);
 
-        cardMap[data.id] = card;   // ✅ STORE POINTER
+    ProblemCard *card = new ProblemCard(data, scrollContent);
 
-        connect(card, &ProblemCard::openRequested,
-                this, &ProblemBrowser::navigateToEditor);
+    cardMap[data.id] = card;   // ✅ STORE POINTER
 
+    connect(card, &ProblemCard::openRequested,
+            this, &ProblemBrowser::navigateToEditor);
+
+    cards[index] = card;
+    return card;
+}
+
+void ProblemBrowser::addCards(int count) {
+    const int end = qMin(nextCard + count, int(shown.size()));
+    for (; nextCard < end; ++nextCard) {
+        ProblemCard *card = cardFor(shown[nextCard]);
+        if (!card) continue;
         listLayout->addWidget(card);
+        card->show();
+    }
 
+    if (nextCard < shown.size()) {
+        cardTimer.start();
+    } else {
+        cardTimer.stop();
     }
 }
 
 void ProblemBrowser::onProgressChanged(const QString &problemId)
 {
+    // Only this problem's bits change; the list is redone only when the
+    // status filter or the sort order depends on them
+    facets.update(repository->catalog().find(problemId), problemId, progressManager);
+    const ProblemFacets::Filter filter = currentFilter();
+    if (filter.status != ProblemFacets::AnyStatus || filter.sort != ProblemFacets::CatalogOrder) {
+        applyFilters();
+    }
+
     if (!cardMap.contains(problemId))
         return;
 
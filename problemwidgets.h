@@ -2,6 +2,9 @@
 #define PROBLEMWIDGETS_H
 
 #include "progressmanager.h"
+#include "problem_repository.h"
+#include "search_index.h"
+#include "problem_facets.h"
 #include <QWidget>
 #include <QLabel>
 #include <QPushButton>
@@ -14,6 +17,9 @@
 #include <QJsonObject>
 #include <QPainter>
 #include <QFrame>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QTimer>
 
 struct ProblemData {
     QString id;
@@ -59,20 +65,45 @@ private:
 class ProblemBrowser : public QWidget {
     Q_OBJECT
 public:
-    explicit ProblemBrowser(ProgressManager *pm, QWidget *parent = nullptr);
-    void loadFromJson(const QString &filePath);
+    explicit ProblemBrowser(ProgressManager *pm, ProblemRepository *repo, QWidget *parent = nullptr);
+    void loadCatalog();
+    // Path of the problem listed after this one, the likely next pick;
+    // empty at the end of the list
+    QString pathAfter(const QString &problemPath) const;
 
 signals:
     void navigateToEditor(QString problemPath);
 
 private:
+    void addCards(int count);
+    ProblemCard *cardFor(int index);
+    void showProblems(const QList<int> &indexes);
+    QComboBox *addFilter(QHBoxLayout *layout);
+    ProblemFacets::Filter currentFilter() const;
+
     QVBoxLayout *listLayout;
     QWidget *scrollContent;
+    QLineEdit *searchBox;
+    QComboBox *difficultyFilter;
+    QComboBox *topicFilter;
+    QComboBox *statusFilter;
+    QComboBox *sortOrder;
     ProgressManager *progressManager;
     QMap<QString, ProblemCard*> cardMap;   // 🔥 THIS
 
+    // Cards are made from the mapped index a screenful at a time, and only
+    // for problems that are shown
+    ProblemRepository *repository;
+    SearchIndex *searchIndex;
+    ProblemFacets facets;
+    QList<ProblemCard*> cards;   // By catalog record, null until shown
+    QList<int> shown;            // Catalog records in display order
+    QTimer cardTimer;
+    int nextCard = 0;
+
 private slots:
     void onProgressChanged(const QString &problemId);
+    void applyFilters();
 
 
 };
@@ -0,0 +1,204 @@
+#include "process_group.h"
+
+#include <QProcess>
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <poll.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+
+constexpr int ReapTimeoutMs = 1000;
+
+struct GroupMember {
+    qint64 pid = 0;
+    qint64 cpuTicks = 0;
+};
+
+// Parses /proc/<pid>/stat. The command name is wrapped in parentheses and may
+// itself contain spaces or ')', so fields are counted from the last ')'.
+bool readStat(qint64 pid, qint64 &pgrp, qint64 &cpuTicks) {
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const QByteArray line = file.readAll();
+    const int close = line.lastIndexOf(')');
+    if (close < 0) return false;
+
+    // Fields after ")": state(3) ppid(4) pgrp(5) ... utime(14) stime(15)
+    const QList<QByteArray> fields = line.mid(close + 2).split(' ');
+    if (fields.size() < 13) return false;
+
+    pgrp = fields[2].toLongLong();
+    cpuTicks = fields[11].toLongLong() + fields[12].toLongLong();
+    return true;
+}
+
+// Only for a group that outlived its leader, which is rare: it walks all
+// of /proc
+QList<GroupMember> listGroup(qint64 pgid) {
+    QList<GroupMember> members;
+    const QStringList entries = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const qint64 pid = entry.toLongLong(&ok);
+        if (!ok) continue;
+
+        qint64 pgrp = 0;
+        qint64 ticks = 0;
+        if (readStat(pid, pgrp, ticks) && pgrp == pgid) {
+            members.append({pid, ticks});
+        }
+    }
+    return members;
+}
+
+int openPidFd(qint64 pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+#else
+    Q_UNUSED(pid);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Blocks until pid is gone or the deadline passes. Uses a pidfd when the
+// kernel supports it (5.3+), otherwise falls back to polling kill(pid, 0).
+void waitGone(qint64 pid, QElapsedTimer &deadline) {
+    const int fd = openPidFd(pid);
+    if (fd >= 0) {
+        pollfd pfd{fd, POLLIN, 0};
+        const int remaining = qMax<qint64>(0, ReapTimeoutMs - deadline.elapsed());
+        ::poll(&pfd, 1, remaining);
+        ::close(fd);
+        return;
+    }
+
+    while (::kill(static_cast<pid_t>(pid), 0) == 0 && deadline.elapsed() < ReapTimeoutMs) {
+        QThread::msleep(5);
+    }
+}
+
+// Resident set of one process from /proc/<pid>/status, in kB
+qint64 residentOf(qint64 pid) {
+    QFile file(QString("/proc/%1/status").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:")) return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+    return 0;
+}
+
+// pid and its descendants, through /proc/<pid>/task/<tid>/children; only
+// the tree below pid is read
+qint64 treeResidentKb(qint64 pid, int depth = 0) {
+    qint64 kb = residentOf(pid);
+    if (depth > 32) return kb;
+    const QString taskDir = QString("/proc/%1/task").arg(pid);
+    for (const QString &tid : QDir(taskDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile children(taskDir + '/' + tid + "/children");
+        if (!children.open(QIODevice::ReadOnly)) continue;
+        for (const QByteArray &child : children.readAll().split(' ')) {
+            const qint64 childPid = child.trimmed().toLongLong();
+            if (childPid > 0) kb += treeResidentKb(childPid, depth + 1);
+        }
+    }
+    return kb;
+}
+
+ReapStats killGroup(qint64 pgid) {
+    ReapStats stats;
+    if (pgid <= 0) return stats;
+
+    // Common case after a clean exit: nothing left, skip the /proc scan
+    if (::kill(-static_cast<pid_t>(pgid), 0) < 0 && errno == ESRCH) return stats;
+
+    const QList<GroupMember> members = listGroup(pgid);
+    const long ticksPerSec = ::sysconf(_SC_CLK_TCK);
+
+    for (const GroupMember &m : members) {
+        if (m.pid == pgid) continue;
+        stats.leakedProcesses++;
+        if (ticksPerSec > 0) stats.leakedCpuMs += m.cpuTicks * 1000 / ticksPerSec;
+    }
+
+    if (members.isEmpty()) return stats;
+
+    ::kill(-static_cast<pid_t>(pgid), SIGKILL);
+
+    QElapsedTimer deadline;
+    deadline.start();
+    for (const GroupMember &m : members) {
+        // The leader is our own child and is reaped by QProcess; waiting on
+        // its pidfd here would only see it as a zombie.
+        if (m.pid == pgid) continue;
+        waitGone(m.pid, deadline);
+    }
+
+    if (stats.leakedProcesses > 0) {
+        qDebug() << "Reaped" << stats.leakedProcesses << "leaked process(es) from group"
+                 << pgid << "using" << stats.leakedCpuMs << "ms CPU";
+    }
+    return stats;
+}
+
+#endif // Q_OS_LINUX
+
+} // namespace
+
+namespace ProcessGroup {
+
+void isolate(QProcess &process) {
+#ifdef Q_OS_UNIX
+    process.setChildProcessModifier([]() {
+        ::setsid();
+    });
+#else
+    Q_UNUSED(process);
+#endif
+}
+
+ReapStats killTree(qint64 pgid) {
+    // One signal to the group; nothing is enumerated on this path
+#ifdef Q_OS_UNIX
+    if (pgid > 0) ::kill(-static_cast<pid_t>(pgid), SIGKILL);
+#else
+    Q_UNUSED(pgid);
+#endif
+    return {};
+}
+
+ReapStats reap(qint64 pgid) {
+#ifdef Q_OS_LINUX
+    return killGroup(pgid);
+#else
+    return killTree(pgid);
+#endif
+}
+
+qint64 residentKb(qint64 pid) {
+#ifdef Q_OS_LINUX
+    if (pid <= 0) return 0;
+    return treeResidentKb(pid);
+#else
+    Q_UNUSED(pid);
+    return 0;
+#endif
+}
+
+} // namespace ProcessGroup
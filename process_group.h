@@ -0,0 +1,40 @@
+#ifndef PROCESS_GROUP_H
+#define PROCESS_GROUP_H
+
+#include <QtGlobal>
+
+class QProcess;
+
+struct ReapStats {
+    int leakedProcesses = 0;
+    qint64 leakedCpuMs = 0;
+};
+
+// Process-tree control for test runs. On Unix every test is started in its
+// own session, so the solution and anything it forks share one process group
+// (pgid == pid of the solution) that can be signalled and reaped as a unit.
+// On other platforms these fall back to acting on the direct child only.
+namespace ProcessGroup {
+
+// Must be called before QProcess::start().
+void isolate(QProcess &process);
+
+// SIGKILLs the whole group led by pgid, leader included, with one kill()
+// and no /proc scan. The caller still waits for the leader; members are
+// not counted, since the group dies with it.
+ReapStats killTree(qint64 pgid);
+
+// For a group whose leader already exited and was waited for. Normally the
+// group is empty and one kill(-pgid, 0) says so; only when something was
+// left behind is /proc searched for it, and each orphan is killed and
+// reported as leaked with the CPU time it used.
+ReapStats reap(qint64 pgid);
+
+// Resident memory of pid and its descendants right now, in kB (Linux
+// only; 0 elsewhere). Only that tree's /proc entries are read. Sampled to
+// learn how much a compiler and its helpers use.
+qint64 residentKb(qint64 pid);
+
+} // namespace ProcessGroup
+
+#endif // PROCESS_GROUP_H
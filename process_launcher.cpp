@@ -0,0 +1,266 @@
+#include "process_launcher.h"
+#include "sandbox.h"
+
+#include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// Anything beyond this is a runaway loop; the child gets SIGXFSZ
+constexpr qint64 OutputLimitBytes = 256LL * 1024 * 1024;
+
+} // namespace
+
+LaunchSpec LaunchSpec::build(const LanguageConfig &cfg, const QString &workDir,
+                             const Sandbox *sandbox) {
+    LaunchSpec spec;
+#ifdef Q_OS_UNIX
+    QString program = cfg.expand(cfg.runCommand, workDir);
+    if (!program.contains('/')) {
+        program = QStandardPaths::findExecutable(program);
+    } else if (QDir::isRelativePath(program)) {
+        program = QDir(workDir).absoluteFilePath(program);
+    }
+    if (program.isEmpty()) return spec;
+
+    spec.m_workDir = QFile::encodeName(workDir);
+    spec.m_args.append(QFile::encodeName(program));
+    for (const QString &arg : cfg.expandArgs(cfg.runArgs, workDir)) {
+        spec.m_args.append(arg.toLocal8Bit());
+    }
+
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    for (auto it = cfg.environment.begin(); it != cfg.environment.end(); ++it) {
+        env.insert(it.key(), cfg.expand(it.value(), workDir));
+    }
+    for (const QString &entry : env.toStringList()) {
+        spec.m_env.append(entry.toLocal8Bit());
+    }
+
+    // Generous: the wall-clock timeout is what decides TLE, this only stops
+    // a runaway child if the runner itself is gone. Set per launch from the
+    // timeout it runs under.
+    spec.m_cpuBackstop = true;
+    spec.m_outputLimitBytes = OutputLimitBytes;
+    spec.m_sandbox = sandbox;
+
+    for (QByteArray &arg : spec.m_args) spec.m_argv.push_back(arg.data());
+    spec.m_argv.push_back(nullptr);
+    for (QByteArray &entry : spec.m_env) spec.m_envp.push_back(entry.data());
+    spec.m_envp.push_back(nullptr);
+
+    spec.m_program = spec.m_args.first();
+#else
+    Q_UNUSED(cfg);
+    Q_UNUSED(workDir);
+    Q_UNUSED(sandbox);
+#endif
+    return spec;
+}
+
+#ifdef Q_OS_UNIX
+
+namespace {
+
+constexpr int PollSliceMs = 5;       // Exit polling when pidfd is unavailable
+
+} // namespace
+
+void ProcessLauncher::closeFd(int &fd) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+int ProcessLauncher::openPidfd(qint64 pid) {
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    return int(::syscall(SYS_pidfd_open, pid_t(pid), 0));   // pidfds are always close-on-exec
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+bool ProcessLauncher::spawn(const LaunchSpec &spec, const QByteArray &input, int timeoutMs,
+                            Child &child, QString &error) {
+    MemoryFile stdinFile;
+    if (!stdinFile.create("stdin") || !stdinFile.write(input) ||
+        !child.standardOutput.create("stdout") || !child.standardError.create("stderr")) {
+        error = QString("Failed to create test I/O files: ") + strerror(errno);
+        return false;
+    }
+
+    const int inFd = stdinFile.fd();
+    const int outFd = child.standardOutput.fd();
+    const int errFd = child.standardError.fd();
+    const char *path = spec.m_program.constData();
+    const char *cwd = spec.m_workDir.constData();
+    char *const *argv = spec.m_argv.data();
+    char *const *envp = spec.m_envp.data();
+    const rlim_t cpuLimit = spec.m_cpuBackstop ? rlim_t(timeoutMs / 1000 + 2) : 0;
+    const rlim_t outputLimit = rlim_t(spec.m_outputLimitBytes);
+    const Sandbox *sandbox = spec.m_sandbox;
+
+    // Keep signal handlers from running in the child while it shares our
+    // memory; the child restores the original mask right before execve().
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+
+    // Written by the child through the shared address space
+    volatile int execErrno = 0;
+
+    child.started.start();
+
+    const pid_t pid = ::vfork();
+    if (pid == 0) {
+        // Own process group (pgid == pid) like ProcessGroup::isolate()
+        ::setpgid(0, 0);
+        ::dup2(inFd, STDIN_FILENO);
+        ::dup2(outFd, STDOUT_FILENO);
+        ::dup2(errFd, STDERR_FILENO);
+        // Joins namespaces set up in advance, so this stays cheap
+        if (sandbox) {
+            const int sandboxErrno = sandbox->enter();
+            if (sandboxErrno != 0) {
+                execErrno = sandboxErrno;
+                ::_exit(127);
+            }
+        }
+        if (::chdir(cwd) < 0) {
+            execErrno = errno;
+            ::_exit(127);
+        }
+        if (cpuLimit > 0) {
+            struct rlimit limit = {cpuLimit, cpuLimit + 1};
+            ::setrlimit(RLIMIT_CPU, &limit);
+        }
+        if (outputLimit > 0) {
+            struct rlimit limit = {outputLimit, outputLimit};
+            ::setrlimit(RLIMIT_FSIZE, &limit);
+        }
+        struct rlimit noCore = {0, 0};
+        ::setrlimit(RLIMIT_CORE, &noCore);
+
+        for (int sig = 1; sig < NSIG; ++sig) {
+            struct sigaction sa;
+            if (::sigaction(sig, nullptr, &sa) == 0 && sa.sa_handler != SIG_IGN &&
+                sa.sa_handler != SIG_DFL) {
+                ::signal(sig, SIG_DFL);
+            }
+        }
+        ::pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+
+        ::execve(path, argv, envp);
+        execErrno = errno;
+        ::_exit(127);
+    }
+
+    child.spawnUs = child.started.nsecsElapsed() / 1000;
+    const int spawnErrno = errno;
+    pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+
+    if (pid < 0 || execErrno != 0) {
+        error = QString("Failed to start ") + path + ": " +
+                strerror(pid < 0 ? spawnErrno : execErrno);
+        if (pid > 0) ::waitpid(pid, nullptr, 0);
+        return false;
+    }
+
+    child.pid = pid;
+    return true;
+}
+
+void ProcessLauncher::finish(Child &child, int status, Execution &exec) {
+    exec.reaped = ProcessGroup::reap(child.pid);
+    if (WIFSIGNALED(status)) {
+        exec.crashed = true;
+        exec.exitCode = WTERMSIG(status);
+        exec.outputLimitExceeded = exec.exitCode == SIGXFSZ;
+    } else {
+        exec.exitCode = WEXITSTATUS(status);
+    }
+    exec.standardOutput = std::move(child.standardOutput);
+    exec.standardError = std::move(child.standardError);
+}
+
+void ProcessLauncher::kill(Child &child, Execution &exec) {
+    exec.reaped = ProcessGroup::killTree(child.pid);
+    ::waitpid(pid_t(child.pid), nullptr, 0);
+    exec.standardOutput = std::move(child.standardOutput);
+    exec.standardError = std::move(child.standardError);
+}
+
+ProcessLauncher::Execution ProcessLauncher::run(const LaunchSpec &spec, const QByteArray &input,
+                                                int timeoutMs) {
+    Execution exec;
+    Child child;
+
+    // Timed from the vfork(), not from here: writing a large input into the
+    // stdin file is the runner's cost, not the solution's
+    if (!spawn(spec, input, timeoutMs, child, exec.error)) return exec;
+    const QElapsedTimer &timer = child.started;
+    exec.started = true;
+    exec.spawnUs = child.spawnUs;
+
+    int pidfd = openPidfd(child.pid);
+    int status = 0;
+    bool exited = false;
+
+    while (!exited) {
+        const qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            exec.timedOut = true;
+            break;
+        }
+
+        if (pidfd >= 0) {
+            pollfd pfd = {pidfd, POLLIN, 0};
+            ::poll(&pfd, 1, int(remaining));
+        } else {
+            ::poll(nullptr, 0, int(qMin<qint64>(remaining, PollSliceMs)));
+        }
+        exited = ::waitpid(pid_t(child.pid), &status, WNOHANG) == child.pid;
+    }
+
+    exec.elapsedMs = timer.elapsed();
+    closeFd(pidfd);
+
+    if (exited) {
+        finish(child, status, exec);
+    } else {
+        kill(child, exec);
+    }
+    return exec;
+}
+
+#else
+
+bool ProcessLauncher::spawn(const LaunchSpec &, const QByteArray &, int, Child &, QString &error) {
+    error = "Fast launcher not supported on this platform";
+    return false;
+}
+
+ProcessLauncher::Execution ProcessLauncher::run(const LaunchSpec &, const QByteArray &, int) {
+    Execution exec;
+    exec.error = "Fast launcher not supported on this platform";
+    return exec;
+}
+
+#endif
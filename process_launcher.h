@@ -0,0 +1,98 @@
+#ifndef PROCESS_LAUNCHER_H
+#define PROCESS_LAUNCHER_H
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QElapsedTimer>
+#include <vector>
+#include "language_config.h"
+#include "process_group.h"
+#include "memory_file.h"
+
+class Sandbox;
+
+// Everything needed to start a test process, resolved once per run: the
+// program looked up on PATH, argv and envp already expanded and laid out as
+// C arrays, the working directory and the resource limits. Launching from it
+// touches no Qt state and allocates nothing between fork and exec.
+//
+// Not copyable: argv/envp point into the spec's own byte arrays.
+class LaunchSpec {
+public:
+    LaunchSpec() = default;
+    LaunchSpec(LaunchSpec &&) = default;
+    LaunchSpec &operator=(LaunchSpec &&) = default;
+    LaunchSpec(const LaunchSpec &) = delete;
+    LaunchSpec &operator=(const LaunchSpec &) = delete;
+
+    // Invalid when the platform has no fast launcher or the program can't
+    // be resolved; callers then use QProcess. A sandbox, if given, must
+    // outlive the spec.
+    static LaunchSpec build(const LanguageConfig &cfg, const QString &workDir,
+                            const Sandbox *sandbox = nullptr);
+
+    bool isValid() const { return !m_program.isEmpty(); }
+    const QByteArray &program() const { return m_program; }
+
+private:
+    friend class ProcessLauncher;
+
+    QByteArray m_program;
+    QByteArray m_workDir;
+    QByteArrayList m_args;
+    QByteArrayList m_env;
+    std::vector<char *> m_argv;
+    std::vector<char *> m_envp;
+    bool m_cpuBackstop = false;   // RLIMIT_CPU a little above each launch's timeout
+    qint64 m_outputLimitBytes = 0;   // RLIMIT_FSIZE, caps stdout/stderr files
+    const Sandbox *m_sandbox = nullptr;
+};
+
+// Starts a test from a LaunchSpec with vfork()+execve() (no page-table copy
+// and no per-test environment or argument processing). stdin, stdout and
+// stderr are MemoryFiles: the input is written once before the child starts
+// and the output is left in place for the caller to map, so the runner only
+// has to wait for the exit.
+class ProcessLauncher {
+public:
+    struct Execution {
+        bool started = false;
+        QString error;             // Why it did not start
+        bool timedOut = false;
+        bool crashed = false;      // Killed by a signal; exitCode is the signal
+        bool outputLimitExceeded = false;   // Killed by SIGXFSZ
+        int exitCode = 0;
+        MemoryFile standardOutput;
+        MemoryFile standardError;
+        qint64 spawnUs = 0;        // vfork() until the child has exec'd
+        qint64 elapsedMs = 0;      // vfork() until exit; setting up the input is not timed
+        ReapStats reaped;          // Leftovers of the test's process group
+    };
+
+    // A started child
+    struct Child {
+        qint64 pid = 0;            // Also the child's process group
+        MemoryFile standardOutput;
+        MemoryFile standardError;
+        qint64 spawnUs = 0;
+        QElapsedTimer started;     // Right before vfork(); the I/O files are ready by then
+    };
+
+    static Execution run(const LaunchSpec &spec, const QByteArray &input, int timeoutMs);
+
+    // Building blocks shared with ProcessReactor
+    // timeoutMs is the wall-clock limit of this launch; the CPU backstop is
+    // derived from it, so a longer limit (e.g. a batch of tests) gets a
+    // matching one
+    static bool spawn(const LaunchSpec &spec, const QByteArray &input, int timeoutMs,
+                      Child &child, QString &error);
+    static int openPidfd(qint64 pid);
+    static void closeFd(int &fd);
+    // Fills in exit code / signal from a waitpid() status, reaps leftovers
+    // and takes over the child's output files
+    static void finish(Child &child, int status, Execution &exec);
+    // Same for a child that is still running
+    static void kill(Child &child, Execution &exec);
+};
+
+#endif // PROCESS_LAUNCHER_H
@@ -0,0 +1,235 @@
+#include "process_reactor.h"
+
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+
+namespace {
+
+constexpr int MaxEvents = 256;
+constexpr quint64 TimerToken = ~quint64(0);
+
+quint64 token(quint32 generation, int slot) {
+    return (quint64(generation) << 32) | quint64(slot);
+}
+
+} // namespace
+
+ProcessReactor::ProcessReactor() {
+    m_clock.start();
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_timer = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_epoll < 0 || m_timer < 0) {
+        qWarning() << "Process reactor unavailable:" << strerror(errno);
+        ProcessLauncher::closeFd(m_epoll);
+        ProcessLauncher::closeFd(m_timer);
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = TimerToken;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_timer, &ev);
+}
+
+ProcessReactor::~ProcessReactor() {
+    killAll([](int, ProcessLauncher::Execution &) {});
+    ProcessLauncher::closeFd(m_timer);
+    ProcessLauncher::closeFd(m_epoll);
+}
+
+bool ProcessReactor::isSupported() {
+    static const bool supported = []() {
+        int fd = ProcessLauncher::openPidfd(::getpid());
+        if (fd < 0) return false;
+        ::close(fd);
+        return true;
+    }();
+    return supported;
+}
+
+bool ProcessReactor::submit(int tag, const LaunchSpec &spec, const QByteArray &input,
+                            int timeoutMs, QString &error) {
+    if (m_epoll < 0) {
+        error = "Process reactor unavailable";
+        return false;
+    }
+
+    int index;
+    if (!m_free.empty()) {
+        index = m_free.back();
+        m_free.pop_back();
+    } else {
+        index = int(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    Slot &slot = m_slots[index];
+    slot.generation++;
+    slot.tag = tag;
+    slot.child = ProcessLauncher::Child{};
+
+    if (!ProcessLauncher::spawn(spec, input, timeoutMs, slot.child, error)) {
+        slot.child = ProcessLauncher::Child{};
+        m_free.push_back(index);
+        return false;
+    }
+    // From the vfork(), like ProcessLauncher::run(); writing the input is not timed
+    slot.startedMs = m_clock.elapsed() - slot.child.started.elapsed();
+    slot.deadlineMs = slot.startedMs + timeoutMs;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = token(slot.generation, index);
+    slot.pidfd = ProcessLauncher::openPidfd(slot.child.pid);
+    if (slot.pidfd < 0 || ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, slot.pidfd, &ev) < 0) {
+        // Can't supervise it; don't leave it running unobserved
+        error = QString("pidfd: ") + strerror(errno);
+        ProcessLauncher::Execution discarded;
+        ProcessLauncher::kill(slot.child, discarded);
+        ProcessLauncher::closeFd(slot.pidfd);
+        slot.child = ProcessLauncher::Child{};
+        m_free.push_back(index);
+        return false;
+    }
+
+    slot.used = true;
+    m_active++;
+
+    if (m_armedMs < 0 || slot.deadlineMs < m_armedMs) armTimer();
+    return true;
+}
+
+void ProcessReactor::poll(const Completion &done, int timeoutMs) {
+    if (m_epoll < 0 || m_active == 0) return;
+
+    epoll_event events[MaxEvents];
+    const int count = ::epoll_wait(m_epoll, events, MaxEvents, timeoutMs);
+    // Everything in this batch had exited by the time epoll_wait returned
+    const qint64 now = m_clock.elapsed();
+
+    std::vector<Finished> finished;
+    bool timerFired = false;
+    for (int i = 0; i < count; ++i) {
+        const quint64 data = events[i].data.u64;
+        if (data == TimerToken) {
+            quint64 expirations = 0;
+            (void)::read(m_timer, &expirations, sizeof expirations);
+            m_armedMs = -1;
+            timerFired = true;
+            continue;
+        }
+
+        const int index = int(data & 0xffffffffu);
+        if (index >= int(m_slots.size())) continue;
+        Slot &slot = m_slots[index];
+        if (!slot.used || slot.generation != quint32(data >> 32)) continue;
+
+        int status = 0;
+        if (::waitpid(pid_t(slot.child.pid), &status, WNOHANG) == slot.child.pid) {
+            finished.push_back(complete(index, status, false, now));
+        }
+    }
+
+    // Deadlines go last: a child whose exit is in the same batch as the
+    // timer has already been reaped above and is not reported as a timeout
+    if (timerFired) expire(now, finished);
+    if (m_armedMs < 0) armTimer();
+
+    for (Finished &f : finished) done(f.tag, f.exec);
+}
+
+ProcessReactor::Finished ProcessReactor::complete(int index, int status, bool killed, qint64 nowMs) {
+    Slot &slot = m_slots[index];
+
+    Finished finished;
+    finished.tag = slot.tag;
+    ProcessLauncher::Execution &exec = finished.exec;
+    exec.started = true;
+    exec.spawnUs = slot.child.spawnUs;
+    exec.elapsedMs = nowMs - slot.startedMs;
+    exec.timedOut = killed;
+
+    // Closing the pidfd also drops it from the epoll set
+    ProcessLauncher::closeFd(slot.pidfd);
+    if (killed) {
+        ProcessLauncher::kill(slot.child, exec);
+    } else {
+        ProcessLauncher::finish(slot.child, status, exec);
+    }
+
+    slot.used = false;
+    slot.child = ProcessLauncher::Child{};
+    m_free.push_back(index);
+    m_active--;
+
+    return finished;
+}
+
+void ProcessReactor::expire(qint64 nowMs, std::vector<Finished> &finished) {
+    for (int i = 0; i < int(m_slots.size()); ++i) {
+        Slot &slot = m_slots[i];
+        if (!slot.used || slot.deadlineMs > nowMs) continue;
+
+        // It may have exited with its pidfd event still to come
+        int status = 0;
+        const bool exited = ::waitpid(pid_t(slot.child.pid), &status, WNOHANG) == slot.child.pid;
+        finished.push_back(complete(i, status, !exited, nowMs));
+    }
+}
+
+void ProcessReactor::killAll(const Completion &done) {
+    const qint64 now = m_clock.elapsed();
+    std::vector<Finished> finished;
+    for (int i = 0; i < int(m_slots.size()); ++i) {
+        if (m_slots[i].used) finished.push_back(complete(i, 0, true, now));
+    }
+    m_armedMs = -1;
+
+    for (Finished &f : finished) done(f.tag, f.exec);
+}
+
+void ProcessReactor::armTimer() {
+    qint64 earliest = -1;
+    for (const Slot &slot : m_slots) {
+        if (slot.used && (earliest < 0 || slot.deadlineMs < earliest)) earliest = slot.deadlineMs;
+    }
+
+    itimerspec spec{};
+    if (earliest >= 0) {
+        // A zero it_value would disarm the timer; fire in 1 ms instead
+        const qint64 delay = qMax<qint64>(1, earliest - m_clock.elapsed());
+        spec.it_value.tv_sec = delay / 1000;
+        spec.it_value.tv_nsec = (delay % 1000) * 1000000;
+    }
+    ::timerfd_settime(m_timer, 0, &spec, nullptr);
+    m_armedMs = earliest;
+}
+
+#else
+
+ProcessReactor::ProcessReactor() {}
+ProcessReactor::~ProcessReactor() {}
+
+bool ProcessReactor::isSupported() {
+    return false;
+}
+
+bool ProcessReactor::submit(int, const LaunchSpec &, const QByteArray &, int, QString &error) {
+    error = "Process reactor not supported on this platform";
+    return false;
+}
+
+void ProcessReactor::poll(const Completion &, int) {}
+void ProcessReactor::killAll(const Completion &) {}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef PROCESS_REACTOR_H
+#define PROCESS_REACTOR_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <functional>
+#include <vector>
+#include "process_launcher.h"
+
+// Supervises many test processes from a single thread. Tests read and write
+// MemoryFiles, so the only things to watch are exits (one pidfd per child)
+// and deadlines (one timerfd armed for the earliest), all in one epoll set.
+// There is no thread and no blocking wait per child; each child costs a
+// fixed slot plus whatever output it writes to its files.
+//
+// Linux only (pidfd needs 5.3+). Elsewhere isSupported() is false and tests
+// run one at a time through ProcessLauncher::run().
+class ProcessReactor {
+public:
+    using Completion = std::function<void(int tag, ProcessLauncher::Execution &exec)>;
+
+    ProcessReactor();
+    ~ProcessReactor();
+    ProcessReactor(const ProcessReactor &) = delete;
+    ProcessReactor &operator=(const ProcessReactor &) = delete;
+
+    static bool isSupported();
+
+    // Starts a child for tag. On failure error says why and nothing is
+    // reported for tag later.
+    bool submit(int tag, const LaunchSpec &spec, const QByteArray &input, int timeoutMs,
+                QString &error);
+    int active() const { return m_active; }
+
+    // Waits up to timeoutMs (-1: until something happens) and reports every
+    // child that finished (exited or hit its deadline) through done. All of
+    // a batch is reaped and timed before done runs for any of it, so a slow
+    // callback does not add to the other children's times.
+    void poll(const Completion &done, int timeoutMs = -1);
+
+    // Kills all running children and reports them through done
+    void killAll(const Completion &done);
+
+private:
+    struct Slot {
+        bool used = false;
+        quint32 generation = 0;    // Tells stale epoll events from a reused slot
+        int tag = 0;
+        ProcessLauncher::Child child;
+        int pidfd = -1;
+        qint64 startedMs = 0;
+        qint64 deadlineMs = 0;
+    };
+
+    struct Finished {
+        int tag;
+        ProcessLauncher::Execution exec;
+    };
+
+    Finished complete(int slot, int status, bool killed, qint64 nowMs);
+    void expire(qint64 nowMs, std::vector<Finished> &finished);
+    void armTimer();
+
+    int m_epoll = -1;
+    int m_timer = -1;
+    QElapsedTimer m_clock;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_free;
+    int m_active = 0;
+    qint64 m_armedMs = -1;         // Deadline the timerfd is set for, -1 when idle
+};
+
+#endif // PROCESS_REACTOR_H
@@ -90,6 +90,9 @@ void ProgressManager::markSolved(const QString &id, bool solved)
 
     QJsonObject obj = progressData.value(id).toObject();
     obj["solved"] = solved;
+    if (solved) {
+        obj["lastSolvedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    }
 
     progressData[id] = obj;
 
@@ -119,3 +122,33 @@ void ProgressManager::toggleStar(const QString &id)
     save();
     emit progressChanged(id);
 }
+
+int ProgressManager::attempts(const QString &id) const
+{
+    if (!progressData.contains(id))
+        return 0;
+
+    QJsonObject obj = progressData.value(id).toObject();
+    return obj.value("attempts").toInt(0);
+}
+
+void ProgressManager::recordAttempt(const QString &id)
+{
+    ensureProblemExists(id);
+
+    QJsonObject obj = progressData.value(id).toObject();
+    obj["attempts"] = obj.value("attempts").toInt(0) + 1;
+    progressData[id] = obj;
+
+    save();
+    emit progressChanged(id);
+}
+
+QDateTime ProgressManager::lastSolved(const QString &id) const
+{
+    if (!progressData.contains(id))
+        return QDateTime();
+
+    QJsonObject obj = progressData.value(id).toObject();
+    return QDateTime::fromString(obj.value("lastSolvedAt").toString(), Qt::ISODate);
+}
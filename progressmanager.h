@@ -3,6 +3,7 @@
 
 
 #include <QObject>
+#include <QDateTime>
 #include <QJsonObject>
 #include <QString>
 
@@ -22,6 +23,12 @@ public:
     bool isStarred(const QString &id) const;
     void toggleStar(const QString &id);
 
+    // Submissions, counted whether they passed or not
+    int attempts(const QString &id) const;
+    void recordAttempt(const QString &id);
+    // Invalid if the problem was never solved
+    QDateTime lastSolved(const QString &id) const;
+
 signals:
     void progressChanged(const QString &problemId);
 
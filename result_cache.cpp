@@ -0,0 +1,158 @@
+#include "result_cache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QDebug>
+#include <algorithm>
+
+ResultCache::ResultCache(const QString &filePath) : m_filePath(filePath) {
+    if (m_filePath.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_filePath = dir + "/result_cache.json";
+    }
+}
+
+QByteArray ResultCache::hash(const QByteArray &data) {
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+QByteArray ResultCache::artifactHash(const QString &workDir, const LanguageConfig &cfg) {
+    // Everything in the work directory after compilation makes up the
+    // artifact: the binary for C/C++/Go/Rust, all .class files for Java, the
+    // script itself for interpreted languages.
+    QStringList files;
+    QDirIterator it(workDir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) files << it.next();
+    files.sort();
+
+    QCryptographicHash h(QCryptographicHash::Sha256);
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        h.addData(QDir(workDir).relativeFilePath(path).toUtf8());
+        h.addData(&file);
+    }
+
+    // The same artifact launched differently is a different solution.
+    h.addData(cfg.runCommand.toUtf8());
+    h.addData(cfg.runArgs.join('\n').toUtf8());
+    for (auto e = cfg.environment.begin(); e != cfg.environment.end(); ++e) {
+        h.addData((e.key() + "=" + e.value()).toUtf8());
+    }
+    return h.result().toHex();
+}
+
+QByteArray ResultCache::makeKey(const QByteArray &artifactHash, const QByteArray &inputHash,
+                                const QByteArray &expectedHash, const LanguageConfig &cfg,
+                                bool sandboxed) {
+    QByteArray limits = QByteArray::number(cfg.timeout) + "/" + QByteArray::number(cfg.memoryLimitMB);
+    // The runner and the sandbox decide which syscalls and resources a
+    // solution gets, so they can turn Accepted into Runtime Error
+    QByteArray environment = cfg.runner.toUtf8() + "/" + (sandboxed ? "sandbox" : "plain");
+    return hash(artifactHash + ":" + inputHash + ":" + expectedHash + ":" + limits + ":" + environment);
+}
+
+bool ResultCache::isCacheable(const QString &status, const QString &output) {
+    if (status != "Accepted" && status != "Wrong Answer" && status != "Runtime Error") {
+        return false;
+    }
+    return output.size() <= MaxOutputBytes;
+}
+
+bool ResultCache::lookup(const QByteArray &key, CachedResult &result) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return false;
+
+    it->lastUsed = ++m_clock;
+    result = *it;
+    return true;
+}
+
+qint64 ResultCache::sizeOf(const QByteArray &key, const CachedResult &entry) {
+    // Roughly what the entry takes in the compact JSON
+    return key.size() + entry.status.size() + entry.output.size() + entry.expected.size() + 64;
+}
+
+void ResultCache::store(const QByteArray &key, const CachedResult &result) {
+    CachedResult entry = result;
+    entry.lastUsed = ++m_clock;
+    m_entries.insert(key, entry);
+    m_dirty = true;
+}
+
+void ResultCache::clear() {
+    m_entries.clear();
+    m_dirty = true;
+}
+
+void ResultCache::load() {
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    m_entries.clear();
+    m_clock = 0;
+    for (auto it = root.begin(); it != root.end(); ++it) {
+        QJsonObject obj = it.value().toObject();
+        CachedResult entry;
+        entry.status = obj["status"].toString();
+        entry.output = obj["output"].toString();
+        entry.expected = obj["expected"].toString();
+        entry.timeMs = obj["timeMs"].toInteger();
+        entry.lastUsed = obj["lastUsed"].toInteger();
+        m_clock = qMax(m_clock, entry.lastUsed);
+        m_entries.insert(it.key().toLatin1(), entry);
+    }
+    m_dirty = false;
+
+    qDebug() << "Result cache:" << m_entries.size() << "entries from" << m_filePath;
+}
+
+void ResultCache::save() {
+    if (!m_dirty) return;
+
+    // Evict least recently used entries until the file fits the cap
+    qint64 total = 0;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) total += sizeOf(it.key(), *it);
+    if (total > MaxBytes) {
+        QList<QPair<qint64, QByteArray>> byAge;
+        byAge.reserve(m_entries.size());
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            byAge.append({it->lastUsed, it.key()});
+        }
+        std::sort(byAge.begin(), byAge.end());
+        for (const auto &[stamp, key] : byAge) {
+            if (total <= MaxBytes) break;
+            total -= sizeOf(key, m_entries.value(key));
+            m_entries.remove(key);
+        }
+    }
+
+    QJsonObject root;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        QJsonObject obj;
+        obj["status"] = it->status;
+        obj["output"] = it->output;
+        if (!it->expected.isEmpty()) obj["expected"] = it->expected;
+        obj["timeMs"] = it->timeMs;
+        obj["lastUsed"] = it->lastUsed;
+        root[QString::fromLatin1(it.key())] = obj;
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save result cache:" << m_filePath;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (file.commit()) m_dirty = false;
+}
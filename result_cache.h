@@ -0,0 +1,57 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include "language_config.h"
+
+struct CachedResult {
+    QString status;
+    QString output;
+    QString expected;   // Expected side of a digest-mode diff, else empty
+    qint64 timeMs = 0;
+    qint64 lastUsed = 0;
+};
+
+// Verdict cache for re-judging. A result is keyed by everything that can
+// change it: the compiled artifact, the test input, the expected output,
+// the limits it ran under, the runner and whether the sandbox was on.
+// Persisted as JSON in the app data directory.
+//
+// Hits only move an entry's LRU stamp in memory; the stamps reach the disk
+// with the next save that has new results to write.
+class ResultCache {
+public:
+    explicit ResultCache(const QString &filePath = QString());
+
+    static QByteArray hash(const QByteArray &data);
+    static QByteArray artifactHash(const QString &workDir, const LanguageConfig &cfg);
+    static QByteArray makeKey(const QByteArray &artifactHash, const QByteArray &inputHash,
+                              const QByteArray &expectedHash, const LanguageConfig &cfg,
+                              bool sandboxed);
+
+    // Verdicts that depend on machine load or on the user are never cached.
+    static bool isCacheable(const QString &status, const QString &output);
+
+    bool lookup(const QByteArray &key, CachedResult &result);
+    void store(const QByteArray &key, const CachedResult &result);
+    void clear();
+
+    void load();
+    void save();
+
+private:
+    // Bound on the saved file, which is rewritten whole on save()
+    static constexpr qint64 MaxBytes = 8LL * 1024 * 1024;
+    static constexpr int MaxOutputBytes = 64 * 1024;
+
+    static qint64 sizeOf(const QByteArray &key, const CachedResult &entry);
+
+    QHash<QByteArray, CachedResult> m_entries;
+    QString m_filePath;
+    qint64 m_clock = 0;
+    bool m_dirty = false;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,51 @@
+#ifndef RUN_TIMELINE_H
+#define RUN_TIMELINE_H
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// Wall-clock spans of a run's stages (compiling, loading tests, running and
+// comparing each test), measured from the start of the run. Logged when the
+// run finishes, so overlapping stages show up as overlapping spans.
+//
+// nowUs() may be called from any thread; add() only from the runner's.
+class RunTimeline {
+public:
+    struct Span {
+        QString stage;
+        qint64 startUs = 0;
+        qint64 endUs = 0;
+    };
+
+    void start() {
+        m_spans.clear();
+        m_clock.start();
+    }
+
+    qint64 nowUs() const { return m_clock.isValid() ? m_clock.nsecsElapsed() / 1000 : 0; }
+
+    void add(const QString &stage, qint64 startUs, qint64 endUs) {
+        m_spans.append({stage, startUs, endUs});
+    }
+
+    const QList<Span> &spans() const { return m_spans; }
+
+private:
+    QElapsedTimer m_clock;
+    QList<Span> m_spans;
+};
+
+inline QDebug operator<<(QDebug dbg, const RunTimeline &timeline) {
+    QDebugStateSaver saver(dbg);
+    dbg.nospace() << "RunTimeline(";
+    for (const RunTimeline::Span &span : timeline.spans()) {
+        dbg << "\n  " << qPrintable(span.stage.leftJustified(12)) << " "
+            << span.startUs / 1000.0 << " .. " << span.endUs / 1000.0 << " ms";
+    }
+    dbg << ")";
+    return dbg;
+}
+
+#endif // RUN_TIMELINE_H
@@ -0,0 +1,60 @@
+#ifndef RUNNER_METRICS_H
+#define RUNNER_METRICS_H
+
+#include <QtGlobal>
+#include <QDebug>
+
+// Counters collected by CodeRunner over a single run (Run or Submit).
+struct RunnerMetrics {
+    // Processes still alive in a test's process group after the
+    // solution itself exited or was killed, and the CPU they had burned.
+    int leakedProcesses = 0;
+    qint64 leakedCpuMs = 0;
+
+    // Result cache hits and misses
+    int cacheHits = 0;
+    int cacheMisses = 0;
+
+    // Tests started through ProcessLauncher and the time from vfork() until
+    // the child had exec'd
+    int spawns = 0;
+    qint64 spawnTotalUs = 0;
+    qint64 spawnMaxUs = 0;
+    // Setting up the sandbox's namespaces, once per run (SYNTAXFLOW_SANDBOX)
+    qint64 sandboxSetupUs = 0;
+
+    // Multi-test problems: tests judged from a single batched process, and
+    // tests that had to be run again on their own
+    int batchedTests = 0;
+    int batchReruns = 0;
+
+    // Memory admission: jobs admitted and held back for lack of budget, the
+    // most memory reserved at once, and the foreground compiler's peak RSS
+    int memoryAdmitted = 0;
+    int memoryThrottled = 0;
+    qint64 peakReservedMB = 0;
+    qint64 compilePeakMB = 0;
+
+    void reset() { *this = RunnerMetrics{}; }
+};
+
+inline QDebug operator<<(QDebug dbg, const RunnerMetrics &m) {
+    QDebugStateSaver saver(dbg);
+    dbg.nospace() << "RunnerMetrics(leaked=" << m.leakedProcesses
+                  << ", leakedCpuMs=" << m.leakedCpuMs
+                  << ", cacheHits=" << m.cacheHits
+                  << ", cacheMisses=" << m.cacheMisses
+                  << ", spawns=" << m.spawns
+                  << ", spawnAvgUs=" << (m.spawns ? m.spawnTotalUs / m.spawns : 0)
+                  << ", spawnMaxUs=" << m.spawnMaxUs
+                  << ", sandboxSetupUs=" << m.sandboxSetupUs
+                  << ", batchedTests=" << m.batchedTests
+                  << ", batchReruns=" << m.batchReruns
+                  << ", memoryAdmitted=" << m.memoryAdmitted
+                  << ", memoryThrottled=" << m.memoryThrottled
+                  << ", peakReservedMB=" << m.peakReservedMB
+                  << ", compilePeakMB=" << m.compilePeakMB << ")";
+    return dbg;
+}
+
+#endif // RUNNER_METRICS_H
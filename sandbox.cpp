@@ -0,0 +1,344 @@
+#include "sandbox.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QDebug>
+#include <errno.h>
+
+#if defined(Q_OS_LINUX) && (defined(__x86_64__) || defined(__aarch64__))
+#define SANDBOX_SUPPORTED
+#endif
+
+#ifdef SANDBOX_SUPPORTED
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <vector>
+
+// The new mount API, in case the C library predates it
+#ifndef MOUNT_ATTR_RDONLY
+#define MOUNT_ATTR_RDONLY 0x00000001
+#define MOUNT_ATTR_NOSUID 0x00000002
+#endif
+#ifndef OPEN_TREE_CLONE
+#define OPEN_TREE_CLONE 1
+#endif
+#ifndef MOVE_MOUNT_F_EMPTY_PATH
+#define MOVE_MOUNT_F_EMPTY_PATH 0x00000004
+#endif
+#ifndef AT_RECURSIVE
+#define AT_RECURSIVE 0x8000
+#endif
+#endif
+
+bool Sandbox::isRequested() {
+    return qEnvironmentVariableIntValue("SYNTAXFLOW_SANDBOX") != 0;
+}
+
+#ifdef SANDBOX_SUPPORTED
+
+namespace {
+
+constexpr int NamespaceTypes[] = {CLONE_NEWUSER, CLONE_NEWNS, CLONE_NEWNET, CLONE_NEWIPC, CLONE_NEWUTS};
+constexpr const char *NamespaceNames[] = {"user", "mnt", "net", "ipc", "uts"};
+
+// Steps of the template's setup; a failing one is reported with its errno
+enum Step { Done, Fork, Unshare, SetGroups, UidMap, GidMap, Private, ReadOnly, OpenTree, Tmpfs, MoveMount };
+constexpr const char *StepNames[] = {
+    "", "fork", "unshare", "setgroups", "uid_map", "gid_map", "make mounts private",
+    "make the file system read-only", "open the work directory", "mount /tmp", "mount the work directory",
+};
+
+struct Report {
+    int step;
+    int error;
+};
+
+struct MountAttr {
+    quint64 attrSet;
+    quint64 attrClr;
+    quint64 propagation;
+    quint64 usernsFd;
+};
+
+#if defined(__x86_64__)
+constexpr quint32 AuditArch = AUDIT_ARCH_X86_64;
+#else
+constexpr quint32 AuditArch = AUDIT_ARCH_AARCH64;
+#endif
+
+constexpr int BlockedSyscalls[] = {
+    __NR_ptrace, __NR_process_vm_readv, __NR_process_vm_writev,
+    __NR_mount, __NR_umount2, __NR_pivot_root, __NR_chroot, __NR_open_tree, __NR_move_mount,
+    __NR_fsopen, __NR_fsmount, __NR_mount_setattr, __NR_unshare, __NR_setns,
+    __NR_init_module, __NR_finit_module, __NR_delete_module, __NR_kexec_load, __NR_kexec_file_load,
+    __NR_bpf, __NR_perf_event_open, __NR_userfaultfd, __NR_add_key, __NR_request_key, __NR_keyctl,
+    __NR_io_uring_setup, __NR_io_uring_enter, __NR_io_uring_register,
+    __NR_settimeofday, __NR_clock_settime, __NR_clock_adjtime, __NR_adjtimex,
+    __NR_reboot, __NR_swapon, __NR_swapoff, __NR_acct, __NR_quotactl, __NR_syslog,
+    __NR_name_to_handle_at, __NR_open_by_handle_at, __NR_fanotify_init, __NR_vhangup,
+    __NR_pidfd_send_signal,
+};
+
+// Signals that name their target by pid; only the caller itself may be
+// named. Without a PID namespace anything else could be the app.
+constexpr int SignalSyscalls[] = {__NR_tkill, __NR_tgkill, __NR_rt_sigqueueinfo, __NR_rt_tgsigqueueinfo};
+
+// enter() copies the filter onto its stack to fill in the caller's pid
+constexpr int MaxFilterLength = 256;
+
+constexpr quint32 NamespaceFlags = CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWNET | CLONE_NEWIPC |
+                                   CLONE_NEWUTS | CLONE_NEWPID | CLONE_NEWCGROUP;
+
+// selfSlots are the instructions enter() sets to the caller's pid,
+// groupSlot the one it sets to its negation, the caller's own group
+QByteArray buildFilter(QList<int> &selfSlots, int &groupSlot) {
+    const quint32 deny = SECCOMP_RET_ERRNO | EPERM;
+    std::vector<sock_filter> f;
+    selfSlots.clear();
+
+    f.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, arch)));
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AuditArch, 1, 0));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS));
+    f.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)));
+#if defined(__x86_64__)
+    // The x32 ABI numbers the same calls differently
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, 0x40000000, 0, 1));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, deny));
+#endif
+    for (int nr : BlockedSyscalls) {
+        f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, quint32(nr), 0, 1));
+        f.push_back(BPF_STMT(BPF_RET | BPF_K, deny));
+    }
+
+    // kill() may also reach the caller's own group, by 0 or by -pgid; every
+    // test leads its group, so the pgid is the pid. kill(-1) is refused.
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_kill, 0, 6));
+    f.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[0])));   // pid_t
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 3, 0));
+    selfSlots.append(int(f.size()));
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 2, 0));
+    groupSlot = int(f.size());
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 1, 0));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, deny));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+    for (int nr : SignalSyscalls) {
+        f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, quint32(nr), 0, 4));
+        f.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[0])));   // tid or tgid
+        selfSlots.append(int(f.size()));
+        f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 1, 0));
+        f.push_back(BPF_STMT(BPF_RET | BPF_K, deny));
+        f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+    }
+
+    // clone3() hides its flags behind a pointer; the C library falls back
+    // to clone(), whose flags can be checked
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone3, 0, 1));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS));
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_clone, 1, 0));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+    f.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, args[0])));   // Low word
+    f.push_back(BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, NamespaceFlags, 0, 1));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, deny));
+    f.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+
+    Q_ASSERT(f.size() <= size_t(MaxFilterLength));
+    return QByteArray(reinterpret_cast<const char *>(f.data()), qsizetype(f.size() * sizeof(sock_filter)));
+}
+
+// Only raw syscalls from here on: the template is forked from a threaded process
+
+bool writeFile(const char *path, const char *data, qsizetype size) {
+    const int fd = ::open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::write(fd, data, size_t(size)) == size;
+    ::close(fd);
+    return ok;
+}
+
+[[noreturn]] void report(int fd, Step step) {
+    const Report r = {step, step == Done ? 0 : errno};
+    (void)::write(fd, &r, sizeof r);
+    ::_exit(step == Done ? 0 : 1);
+}
+
+// Sets up the namespaces and waits until the runner has opened them
+void buildTemplate(int reportFd, int holdFd, const QByteArray &uidMap, const QByteArray &gidMap,
+                   char *workDir) {
+    if (::unshare(CLONE_NEWUSER | CLONE_NEWNS | CLONE_NEWNET | CLONE_NEWIPC | CLONE_NEWUTS) < 0)
+        report(reportFd, Unshare);
+    if (!writeFile("/proc/self/setgroups", "deny", 4)) report(reportFd, SetGroups);
+    if (!writeFile("/proc/self/uid_map", uidMap.constData(), uidMap.size())) report(reportFd, UidMap);
+    if (!writeFile("/proc/self/gid_map", gidMap.constData(), gidMap.size())) report(reportFd, GidMap);
+
+    if (::mount(nullptr, "/", nullptr, MS_REC | MS_PRIVATE, nullptr) < 0) report(reportFd, Private);
+
+    MountAttr attr = {MOUNT_ATTR_RDONLY | MOUNT_ATTR_NOSUID, 0, 0, 0};
+    if (::syscall(SYS_mount_setattr, AT_FDCWD, "/", AT_RECURSIVE, &attr, sizeof attr) < 0)
+        report(reportFd, ReadOnly);
+
+    // The work directory usually lives in /tmp, which is about to be covered
+    const int tree = int(::syscall(SYS_open_tree, AT_FDCWD, workDir, OPEN_TREE_CLONE | AT_RECURSIVE));
+    if (tree < 0) report(reportFd, OpenTree);
+
+    const char *tmpfsOptions = "size=64m,mode=1777";
+    if (::mount("tmpfs", "/tmp", "tmpfs", MS_NOSUID | MS_NODEV, tmpfsOptions) < 0) report(reportFd, Tmpfs);
+    ::mount("tmpfs", "/dev/shm", "tmpfs", MS_NOSUID | MS_NODEV, tmpfsOptions);
+
+    for (char *p = workDir + 1; *p; ++p) {
+        if (*p != '/') continue;
+        *p = '\0';
+        ::mkdir(workDir, 0755);
+        *p = '/';
+    }
+    ::mkdir(workDir, 0755);
+    if (::syscall(SYS_move_mount, tree, "", AT_FDCWD, workDir, MOVE_MOUNT_F_EMPTY_PATH) < 0)
+        report(reportFd, MoveMount);
+    ::close(tree);
+
+    ::sethostname("sandbox", 7);
+
+    const Report ready = {Done, 0};
+    (void)::write(reportFd, &ready, sizeof ready);
+    char c;
+    (void)::read(holdFd, &c, 1);
+    ::_exit(0);
+}
+
+} // namespace
+
+bool Sandbox::prepare(const QString &workDir, QString &error) {
+    release();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Everything the template needs is built before fork()
+    if (m_filter.isEmpty()) m_filter = buildFilter(m_selfSlots, m_groupSlot);
+    const QByteArray uidMap = QByteArray::number(::getuid()) + ' ' + QByteArray::number(::getuid()) + " 1";
+    const QByteArray gidMap = QByteArray::number(::getgid()) + ' ' + QByteArray::number(::getgid()) + " 1";
+    QByteArray dir = QFile::encodeName(workDir);
+
+    int reportPipe[2];
+    int holdPipe[2];
+    if (::pipe2(reportPipe, O_CLOEXEC) < 0) {
+        error = QString("Sandbox: pipe failed: ") + strerror(errno);
+        return false;
+    }
+    if (::pipe2(holdPipe, O_CLOEXEC) < 0) {
+        error = QString("Sandbox: pipe failed: ") + strerror(errno);
+        ::close(reportPipe[0]);
+        ::close(reportPipe[1]);
+        return false;
+    }
+
+    const pid_t pid = ::fork();
+    const int forkErrno = errno;
+    if (pid == 0) {
+        ::close(reportPipe[0]);
+        ::close(holdPipe[1]);
+        buildTemplate(reportPipe[1], holdPipe[0], uidMap, gidMap, dir.data());
+    }
+    ::close(reportPipe[1]);
+    ::close(holdPipe[0]);
+
+    Report r = {Fork, forkErrno};
+    if (pid > 0 && ::read(reportPipe[0], &r, sizeof r) != sizeof r) r = {Unshare, EPIPE};
+    ::close(reportPipe[0]);
+
+    if (r.step == Done) {
+        for (int i = 0; i < NamespaceCount; ++i) {
+            const QByteArray path = "/proc/" + QByteArray::number(pid) + "/ns/" + NamespaceNames[i];
+            m_namespaces[i] = ::open(path.constData(), O_RDONLY | O_CLOEXEC);
+            if (m_namespaces[i] < 0) {
+                error = QString("Sandbox: failed to open ") + path + ": " + strerror(errno);
+                break;
+            }
+        }
+    } else {
+        error = QString("Sandbox: failed to ") + StepNames[r.step] + ": " + strerror(r.error);
+    }
+
+    // The open descriptors keep the namespaces alive without the template
+    ::close(holdPipe[1]);
+    if (pid > 0) ::waitpid(pid, nullptr, 0);
+
+    m_ready = error.isEmpty();
+    if (!m_ready) {
+        release();
+        return false;
+    }
+
+    m_setupUs = timer.nsecsElapsed() / 1000;
+    qDebug() << "Sandbox ready for" << workDir << "in" << m_setupUs << "us";
+    return true;
+}
+
+void Sandbox::release() {
+    for (int &fd : m_namespaces) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    m_ready = false;
+}
+
+int Sandbox::enter() const {
+    for (int i = 0; i < NamespaceCount; ++i) {
+        if (::setns(m_namespaces[i], NamespaceTypes[i]) < 0) return errno;
+    }
+
+    if (::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) < 0) return errno;
+
+    // The signal rules compare against this process, known only now
+    sock_filter filter[MaxFilterLength];
+    ::memcpy(filter, m_filter.constData(), size_t(m_filter.size()));
+    const quint32 self = quint32(::getpid());
+    for (int slot : m_selfSlots) filter[slot].k = self;
+    filter[m_groupSlot].k = quint32(-qint32(self));
+
+    struct sock_fprog program = {
+        static_cast<unsigned short>(m_filter.size() / sizeof(sock_filter)),
+        filter,
+    };
+    if (::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) < 0) return errno;
+    return 0;
+}
+
+void Sandbox::isolate(QProcess &process, const QString &workDir) const {
+    const QByteArray dir = QFile::encodeName(workDir);
+    process.setChildProcessModifier([this, dir]() {
+        ::setsid();
+        if (enter() != 0 || ::chdir(dir.constData()) < 0) ::_exit(127);
+    });
+}
+
+#else
+
+bool Sandbox::prepare(const QString &, QString &error) {
+    error = "The sandbox needs Linux on x86-64 or AArch64";
+    return false;
+}
+
+void Sandbox::release() {
+    m_ready = false;
+}
+
+int Sandbox::enter() const {
+    return ENOSYS;
+}
+
+void Sandbox::isolate(QProcess &, const QString &) const {
+}
+
+#endif
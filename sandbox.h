@@ -0,0 +1,62 @@
+#ifndef SANDBOX_H
+#define SANDBOX_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+class QProcess;
+
+// Isolation for untrusted test runs (Linux only). Once per work directory a
+// template process unshares user, mount, network, IPC and UTS namespaces
+// and sets up the view a test gets: the file system read-only, private
+// tmpfs mounts on /tmp and /dev/shm, and the work directory mounted back in
+// read-only. Its namespaces are kept open as file descriptors and the
+// template exits right away. A test then only joins them with setns() and
+// installs a prebuilt seccomp filter between vfork() and execve(), so no
+// namespace or mount is created per test.
+//
+// The filter refuses what a solution has no business doing: tracing or
+// reading other processes, mounting, creating namespaces, loading modules
+// or BPF programs, keyrings, io_uring and setting the clock. There is no
+// PID namespace, so signals are confined instead: kill() reaches only the
+// test itself or its own process group, and the thread-directed calls only
+// the test's own threads. enter() fills the test's pid into the filter; a
+// process the test forks inherits it and so can't signal itself by pid.
+//
+// Enabled with SYNTAXFLOW_SANDBOX=1. When that is set and the sandbox can't
+// be set up, runs fail instead of running the code unconfined.
+class Sandbox {
+public:
+    Sandbox() = default;
+    ~Sandbox() { release(); }
+    Sandbox(const Sandbox &) = delete;
+    Sandbox &operator=(const Sandbox &) = delete;
+
+    static bool isRequested();
+
+    bool prepare(const QString &workDir, QString &error);
+    void release();
+    bool isReady() const { return m_ready; }
+    qint64 setupUs() const { return m_setupUs; }
+
+    // Joins the template's namespaces and installs the filter; returns 0 or
+    // an errno. Async-signal-safe, for a child between fork and exec. Joining
+    // the mount namespace resets the working directory, so chdir() after.
+    int enter() const;
+    // ProcessGroup::isolate() for a QProcess that should also enter the
+    // sandbox and run in workDir
+    void isolate(QProcess &process, const QString &workDir) const;
+
+private:
+    static constexpr int NamespaceCount = 5;
+
+    int m_namespaces[NamespaceCount] = {-1, -1, -1, -1, -1};   // user first
+    QByteArray m_filter;       // struct sock_filter[]
+    QList<int> m_selfSlots;    // Instructions enter() sets to the caller's pid
+    int m_groupSlot = -1;      // ... and to its negation
+    qint64 m_setupUs = 0;
+    bool m_ready = false;
+};
+
+#endif // SANDBOX_H
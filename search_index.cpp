@@ -0,0 +1,319 @@
+#include "search_index.h"
+#include "catalog_index.h"
+#include "problem_pack.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr quint32 StoreMagic = 0x53465349;   // "SFSI"
+constexpr quint32 StoreVersion = 1;
+
+// Field weights
+constexpr int TitleWeight = 3;
+constexpr int TopicWeight = 2;
+constexpr int TextWeight = 1;
+
+// How a query word matched an indexed word
+constexpr int ExactScore = 4;
+constexpr int PrefixScore = 2;
+constexpr int InfixScore = 1;
+
+quint64 trigram(const QString &term, qsizetype i) {
+    return (quint64(term[i].unicode()) << 32) | (quint64(term[i + 1].unicode()) << 16) |
+           quint64(term[i + 2].unicode());
+}
+
+QString stripHtml(QString text) {
+    static const QRegularExpression tags("<[^>]*>");
+    text.replace(tags, " ");
+    text.replace("&nbsp;", " ");
+    text.replace("&lt;", "<");
+    text.replace("&gt;", ">");
+    text.replace("&quot;", "\"");
+    text.replace("&#39;", "'");
+    text.replace("&amp;", "&");
+    return text;
+}
+
+QString flatten(const QJsonValue &value) {
+    if (!value.isArray()) return value.toString();
+    QStringList parts;
+    for (const QJsonValue &item : value.toArray()) parts << item.toString();
+    return parts.join('\n');
+}
+
+void addTerms(QHash<QString, int> &terms, const QString &text, int weight) {
+    for (const QString &term : SearchIndex::tokenize(text)) {
+        if (term.size() < 2) continue;   // Single letters match everything
+        int &current = terms[term];
+        current = qMax(current, weight);
+    }
+}
+
+} // namespace
+
+SearchIndex::SearchIndex(QObject *parent)
+    : QObject(parent) {
+}
+
+SearchIndex::~SearchIndex() {
+    // The build only reads problem files and writes the store; let it land
+    if (m_builder) m_builder->wait();
+}
+
+QString SearchIndex::storePath() {
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/search_index.dat";
+}
+
+QStringList SearchIndex::tokenize(const QString &text) {
+    QStringList tokens;
+    QString current;
+    for (QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            current += c.toLower();
+        } else if (!current.isEmpty()) {
+            tokens << current;
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) tokens << current;
+    return tokens;
+}
+
+void SearchIndex::rebuild(const CatalogIndex &catalog, const QString &problemsDir,
+                          const QSharedPointer<const ProblemPack> &pack) {
+    // Results of the old snapshot are record numbers of the old catalog;
+    // callers fall back to something else until the new one is ready
+    m_snapshot.reset();
+
+    // Snapshot what the build needs; the catalog may be reopened meanwhile
+    QList<Source> sources;
+    sources.reserve(catalog.size());
+    for (int i = 0; i < catalog.size(); ++i) {
+        const CatalogIndex::Entry entry = catalog.entry(i);
+        Source source;
+        source.id = entry.id;
+        source.title = entry.title;
+        source.topics = entry.topics;
+        source.filePath = QDir(problemsDir).filePath(entry.path);
+        source.packEntry = ProblemPack::ProblemsDir + entry.path;
+        source.pack = pack;
+        source.key = entry.contentHash ^
+                     CatalogIndex::hash((entry.title + '\n' + entry.topics.join('\n')).toUtf8());
+        sources.append(source);
+    }
+
+    if (m_builder) {
+        m_pending = sources;
+        m_hasPending = true;
+        return;
+    }
+    start(sources);
+}
+
+void SearchIndex::start(const QList<Source> &sources) {
+    auto result = QSharedPointer<QSharedPointer<const Snapshot>>::create();
+    const QString path = storePath();
+
+    m_builder = QThread::create([sources, path, result]() {
+        *result = buildSnapshot(buildDocuments(sources, path));
+    });
+    connect(m_builder, &QThread::finished, this, [this, result]() {
+        m_builder->deleteLater();
+        m_builder = nullptr;
+
+        // A build for an older catalog is thrown away if a newer one queued
+        if (m_hasPending) {
+            m_hasPending = false;
+            start(std::exchange(m_pending, {}));
+            return;
+        }
+        m_snapshot = *result;
+        emit ready();
+    });
+    m_builder->start(QThread::LowPriority);
+}
+
+SearchIndex::Document SearchIndex::readDocument(const Source &source) {
+    Document doc;
+    doc.id = source.id;
+    doc.key = source.key;
+
+    addTerms(doc.terms, source.title, TitleWeight);
+    for (const QString &topic : source.topics) addTerms(doc.terms, topic, TopicWeight);
+
+    QByteArray bytes;
+    if (source.pack) {
+        bytes = source.pack->read(source.packEntry);
+    } else {
+        QFile file(source.filePath);
+        if (file.open(QIODevice::ReadOnly)) bytes = file.readAll();
+    }
+    if (bytes.isEmpty()) return doc;
+    const QJsonObject obj = QJsonDocument::fromJson(bytes).object();
+
+    addTerms(doc.terms, flatten(obj["tags"]), TopicWeight);
+    addTerms(doc.terms, obj["category"].toString(), TopicWeight);
+    addTerms(doc.terms, stripHtml(obj["description"].toString()), TextWeight);
+    addTerms(doc.terms, stripHtml(obj["task"].toString()), TextWeight);
+    addTerms(doc.terms, stripHtml(flatten(obj["constraints"])), TextWeight);
+    return doc;
+}
+
+QList<SearchIndex::Document> SearchIndex::buildDocuments(const QList<Source> &sources,
+                                                         const QString &storePath) {
+    // Terms from the last build, reused while the problem is unchanged
+    QHash<QString, Document> stored;
+    QFile in(storePath);
+    if (in.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&in);
+        quint32 magic = 0, version = 0, count = 0;
+        stream >> magic >> version >> count;
+        if (magic == StoreMagic && version == StoreVersion) {
+            for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                Document doc;
+                stream >> doc.id >> doc.key >> doc.terms;
+                stored.insert(doc.id, doc);
+            }
+        }
+        if (stream.status() != QDataStream::Ok) stored.clear();
+    }
+
+    QList<Document> documents;
+    documents.reserve(sources.size());
+    int reread = 0;
+    for (const Source &source : sources) {
+        auto it = stored.constFind(source.id);
+        if (it != stored.constEnd() && it->key == source.key) {
+            documents.append(*it);
+        } else {
+            documents.append(readDocument(source));
+            ++reread;
+        }
+    }
+
+    if (reread > 0 || stored.size() != documents.size()) {
+        QSaveFile out(storePath);
+        if (out.open(QIODevice::WriteOnly)) {
+            QDataStream stream(&out);
+            stream << StoreMagic << StoreVersion << quint32(documents.size());
+            for (const Document &doc : documents) stream << doc.id << doc.key << doc.terms;
+            if (!out.commit()) qWarning() << "Failed to save search index:" << storePath;
+        }
+    }
+
+    qDebug() << "Search index:" << documents.size() << "problems," << reread << "read";
+    return documents;
+}
+
+QSharedPointer<const SearchIndex::Snapshot> SearchIndex::buildSnapshot(
+    const QList<Document> &documents) {
+    auto snapshot = QSharedPointer<Snapshot>::create();
+    snapshot->docCount = int(documents.size());
+
+    QHash<QString, QList<Posting>> byTerm;
+    for (int doc = 0; doc < documents.size(); ++doc) {
+        const QHash<QString, int> &terms = documents[doc].terms;
+        for (auto it = terms.constBegin(); it != terms.constEnd(); ++it) {
+            byTerm[it.key()].append({doc, it.value()});
+        }
+    }
+
+    snapshot->terms = byTerm.keys();
+    std::sort(snapshot->terms.begin(), snapshot->terms.end());
+    snapshot->postings.reserve(snapshot->terms.size());
+    for (int t = 0; t < snapshot->terms.size(); ++t) {
+        const QString &term = snapshot->terms[t];
+        snapshot->postings.append(byTerm.take(term));
+        for (qsizetype i = 0; i + 3 <= term.size(); ++i) {
+            QList<int> &ids = snapshot->trigrams[trigram(term, i)];
+            if (ids.isEmpty() || ids.last() != t) ids.append(t);
+        }
+    }
+    return snapshot;
+}
+
+QList<int> SearchIndex::search(const QString &query) const {
+    const QStringList words = tokenize(query);
+    if (!m_snapshot || words.isEmpty()) return {};
+    const Snapshot &index = *m_snapshot;
+
+    // Dense per-document arrays: cheaper than hashing with short prefixes,
+    // which can touch a large part of the postings
+    QList<int> total(index.docCount, 0);
+    QList<int> matched(index.docCount, 0);
+    QList<int> best(index.docCount, 0);
+    QList<int> touched;
+
+    for (int w = 0; w < words.size(); ++w) {
+        const QString &word = words[w];
+        touched.clear();
+
+        auto score = [&](int term, int kind) {
+            for (const Posting &p : index.postings[term]) {
+                if (matched[p.doc] != w) continue;   // Missed an earlier word
+                const int s = kind * p.weight;
+                if (best[p.doc] == 0) touched.append(p.doc);
+                best[p.doc] = qMax(best[p.doc], s);
+            }
+        };
+
+        // Words starting with it form one range of the sorted vocabulary
+        auto it = std::lower_bound(index.terms.begin(), index.terms.end(), word);
+        for (; it != index.terms.end() && it->startsWith(word); ++it) {
+            score(int(it - index.terms.begin()), *it == word ? ExactScore : PrefixScore);
+        }
+
+        // Words containing it elsewhere share all of its trigrams
+        if (word.size() >= 3) {
+            QList<const QList<int> *> lists;
+            for (qsizetype i = 0; i + 3 <= word.size(); ++i) {
+                auto found = index.trigrams.constFind(trigram(word, i));
+                if (found == index.trigrams.constEnd()) {
+                    lists.clear();
+                    break;
+                }
+                lists.append(&found.value());
+            }
+            if (!lists.isEmpty()) {
+                std::sort(lists.begin(), lists.end(),
+                          [](const QList<int> *a, const QList<int> *b) { return a->size() < b->size(); });
+                for (int term : *lists.first()) {
+                    const QString &candidate = index.terms[term];
+                    if (!candidate.startsWith(word) && candidate.contains(word)) {
+                        score(term, InfixScore);
+                    }
+                }
+            }
+        }
+
+        for (int doc : touched) {
+            matched[doc] = w + 1;
+            total[doc] += best[doc];
+            best[doc] = 0;
+        }
+    }
+
+    QList<int> results;
+    for (int doc = 0; doc < index.docCount; ++doc) {
+        if (matched[doc] == words.size()) results.append(doc);
+    }
+    std::stable_sort(results.begin(), results.end(),
+                     [&](int a, int b) { return total[a] > total[b]; });
+    return results;
+}
@@ -0,0 +1,87 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QStringList>
+
+class CatalogIndex;
+class ProblemPack;
+class QThread;
+
+// Full-text search over the problem catalog. Titles, topics, tags and the
+// description, task and constraints (HTML stripped) are tokenized into an
+// inverted index; a query term matches whole words, word prefixes and,
+// through a trigram index over the vocabulary, any word containing it.
+//
+// Building reads every problem file, so it runs on a background thread.
+// The per-problem terms are kept in the app data directory next to the
+// catalog index, and only problems whose file or catalog entry changed
+// are read again on the next build.
+class SearchIndex : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject *parent = nullptr);
+    ~SearchIndex() override;
+
+    // Starts a background build for the catalog's current contents; the
+    // problem files are read from the pack when there is one. Not ready
+    // again until that build is done.
+    void rebuild(const CatalogIndex &catalog, const QString &problemsDir,
+                 const QSharedPointer<const ProblemPack> &pack = {});
+    bool isReady() const { return !m_snapshot.isNull(); }
+
+    // Catalog record numbers matching every word of the query, best first
+    QList<int> search(const QString &query) const;
+
+    static QStringList tokenize(const QString &text);
+
+signals:
+    void ready();
+
+private:
+    // Terms of one problem with their field weight, as persisted
+    struct Document {
+        QString id;
+        quint64 key = 0;   // Problem file hash mixed with its catalog entry
+        QHash<QString, int> terms;
+    };
+
+    struct Source {
+        QString id;
+        QString title;
+        QStringList topics;
+        QString filePath;
+        QString packEntry;
+        QSharedPointer<const ProblemPack> pack;
+        quint64 key = 0;
+    };
+
+    struct Posting {
+        int doc;
+        int weight;
+    };
+
+    struct Snapshot {
+        int docCount = 0;
+        QStringList terms;                    // Sorted, for prefix ranges
+        QList<QList<Posting>> postings;       // Parallel to terms, by doc
+        QHash<quint64, QList<int>> trigrams;  // Trigram -> term numbers
+    };
+
+    void start(const QList<Source> &sources);
+    static QList<Document> buildDocuments(const QList<Source> &sources, const QString &storePath);
+    static QSharedPointer<const Snapshot> buildSnapshot(const QList<Document> &documents);
+    static Document readDocument(const Source &source);
+    static QString storePath();
+
+    QSharedPointer<const Snapshot> m_snapshot;
+    QThread *m_builder = nullptr;
+    QList<Source> m_pending;       // Queued while a build is running
+    bool m_hasPending = false;
+};
+
+#endif // SEARCH_INDEX_H
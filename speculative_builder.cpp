@@ -0,0 +1,242 @@
+#include "speculative_builder.h"
+#include "process_group.h"
+#include "native_harness.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int AdmissionRetryMs = 250;
+constexpr int RssSampleMs = 100;
+
+} // namespace
+
+SpeculativeBuilder::SpeculativeBuilder(QObject *parent) : QObject(parent) {
+    m_timeout.setSingleShot(true);
+    connect(&m_timeout, &QTimer::timeout, this, [this]() {
+        qDebug() << "Speculative build timed out";
+        cancel();
+    });
+
+    m_admissionRetry.setSingleShot(true);
+    m_admissionRetry.setInterval(AdmissionRetryMs);
+    connect(&m_admissionRetry, &QTimer::timeout, this, [this]() {
+        if (!m_process && !m_pendingHash.isEmpty()) startCompile();
+    });
+
+    m_sampler.setInterval(RssSampleMs);
+    connect(&m_sampler, &QTimer::timeout, this, [this]() {
+        if (m_process) {
+            m_peakRssKb = qMax(m_peakRssKb, ProcessGroup::residentKb(m_process->processId()));
+        }
+    });
+}
+
+SpeculativeBuilder::~SpeculativeBuilder() {
+    cancel();
+    discardReady();
+}
+
+QByteArray SpeculativeBuilder::sourceHash(const QString &code, const LanguageConfig &cfg) {
+    QCryptographicHash h(QCryptographicHash::Sha256);
+    h.addData(cfg.id.toUtf8());
+    h.addData(cfg.compileCommand.toUtf8());
+    h.addData(cfg.compileArgs.join('\n').toUtf8());
+    h.addData(cfg.runner.toUtf8());
+    h.addData(cfg.sourceFile.toUtf8());
+    h.addData(code.toUtf8());
+    return h.result().toHex();
+}
+
+void SpeculativeBuilder::request(const QString &code, const LanguageConfig &cfg) {
+    if (!cfg.isValid() || !cfg.compiled) return;
+
+    const QByteArray hash = sourceHash(code, cfg);
+    if (hash == m_pendingHash || hash == m_readyHash) return;
+
+    // Superseded: the user kept typing
+    cancel();
+    discardReady();
+
+    QString temp = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+    QString dir = temp + "/CodeHour_" + cfg.id + "_spec_" +
+                  QString::number(QDateTime::currentMSecsSinceEpoch());
+    if (!QDir().mkpath(dir)) return;
+
+    QFile file(dir + "/" + cfg.sourceFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QDir(dir).removeRecursively();
+        return;
+    }
+    file.write(code.toUtf8());
+    file.close();
+
+    m_pendingHash = hash;
+    m_pendingDir = dir;
+    m_pendingCfg = cfg;
+
+    if (NativeHarness::isEnabled(cfg)) NativeHarness::install(dir);
+
+    m_elapsed.start();
+    startCompile();
+}
+
+void SpeculativeBuilder::startCompile() {
+    const QString &dir = m_pendingDir;
+    const LanguageConfig &cfg = m_pendingCfg;
+
+    // A background build is optional; it waits rather than overcommit
+    if (m_admission) {
+        const qint64 estimate = m_admission->compileEstimateMB(cfg);
+        if (!m_admission->tryAdmit(estimate)) {
+            qDebug() << "Speculative compile deferred: needs" << estimate << "MB, reserved"
+                     << m_admission->reservedMB() << "of" << m_admission->budgetMB() << "MB";
+            m_admissionRetry.start();
+            return;
+        }
+        m_admittedMB = estimate;
+    }
+
+    m_process = new QProcess(this);
+    m_process->setWorkingDirectory(dir);
+#ifdef Q_OS_UNIX
+    // Own process group so cancel() also takes cc1plus/ld with it, and a low
+    // priority so typing stays responsive.
+    m_process->setChildProcessModifier([]() {
+        ::setsid();
+        ::setpriority(PRIO_PROCESS, 0, 10);
+    });
+#endif
+    connect(m_process, &QProcess::finished, this, &SpeculativeBuilder::onFinished);
+
+    QString cmd = cfg.expand(cfg.compileCommand, dir);
+    QStringList args = NativeHarness::compileArgs(cfg, dir);
+
+    qDebug() << "Speculative compile:" << cmd << args;
+
+    m_process->start(cmd, args);
+    m_timeout.start(cfg.compileTimeout);
+    m_peakRssKb = 0;
+    m_sampler.start();
+}
+
+void SpeculativeBuilder::releaseAdmission() {
+    m_sampler.stop();
+    if (m_admission && m_admittedMB > 0) m_admission->release(m_admittedMB);
+    m_admittedMB = 0;
+}
+
+void SpeculativeBuilder::cancel() {
+    m_timeout.stop();
+    m_admissionRetry.stop();
+    releaseAdmission();
+
+    if (m_process) {
+        disconnect(m_process, nullptr, this, nullptr);
+        if (m_process->state() != QProcess::NotRunning) {
+            ProcessGroup::killTree(m_process->processId());
+            m_process->kill();
+            m_process->waitForFinished(1000);
+        }
+        m_process->deleteLater();
+        m_process = nullptr;
+    }
+
+    if (!m_pendingDir.isEmpty()) {
+        QDir(m_pendingDir).removeRecursively();
+    }
+    m_pendingDir.clear();
+    m_pendingHash.clear();
+}
+
+void SpeculativeBuilder::discardReady() {
+    if (!m_ready.dir.isEmpty()) {
+        QDir(m_ready.dir).removeRecursively();
+    }
+    m_ready = SpeculativeBuild{};
+    m_readyHash.clear();
+}
+
+bool SpeculativeBuilder::has(const QByteArray &hash) const {
+    return (m_process && hash == m_pendingHash) || hash == m_readyHash;
+}
+
+SpeculativeBuild SpeculativeBuilder::take(const QByteArray &hash, int waitMs) {
+    if (m_process && hash == m_pendingHash) {
+        // finished() is delivered synchronously from inside the wait; it may
+        // start a second compile without the native harness
+        QElapsedTimer waited;
+        waited.start();
+        while (m_process && hash == m_pendingHash) {
+            if (!m_process->waitForFinished(qMax(0, waitMs - int(waited.elapsed())))) {
+                cancel();
+                break;
+            }
+        }
+    } else if (m_process) {
+        // Stale build; don't let it compete with the real one for CPU
+        cancel();
+    }
+
+    // Still waiting for admission; the caller compiles it in the foreground
+    if (!m_process && !m_pendingHash.isEmpty()) cancel();
+
+    if (hash != m_readyHash) return {};
+
+    SpeculativeBuild build = m_ready;
+    m_ready = SpeculativeBuild{};
+    m_readyHash.clear();
+    return build;
+}
+
+void SpeculativeBuilder::onFinished(int exitCode, QProcess::ExitStatus exitStatus) {
+    m_timeout.stop();
+    releaseAdmission();
+
+    SpeculativeBuild build;
+    build.dir = m_pendingDir;
+    build.success = exitStatus == QProcess::NormalExit && exitCode == 0;
+    if (m_admission && exitStatus == QProcess::NormalExit) {
+        m_admission->recordCompilePeak(m_pendingCfg, m_peakRssKb);
+    }
+
+    QString output = QString(m_process->readAllStandardError());
+    if (output.isEmpty()) output = QString(m_process->readAllStandardOutput());
+
+    if (!build.success && NativeHarness::isInstalled(build.dir) &&
+        NativeHarness::isHarnessError(output)) {
+        // The toolchain rejects the harness; retry with the plain source
+        NativeHarness::reject(m_pendingCfg);
+        NativeHarness::uninstall(build.dir);
+        m_process->deleteLater();
+        m_process = nullptr;
+        startCompile();
+        return;
+    }
+    if (!build.success) build.error = output;
+
+    qDebug() << "Speculative build" << (build.success ? "succeeded" : "failed")
+             << "in" << m_elapsed.elapsed() << "ms";
+
+    discardReady();
+    m_ready = build;
+    m_readyHash = m_pendingHash;
+
+    const QString sourceFile = m_pendingCfg.sourceFile;
+    m_pendingDir.clear();
+    m_pendingHash.clear();
+    m_process->deleteLater();
+    m_process = nullptr;
+
+    emit diagnosticsReady(m_readyHash, CompileDiagnostics::parse(output, sourceFile));
+}
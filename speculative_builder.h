@@ -0,0 +1,73 @@
+#ifndef SPECULATIVE_BUILDER_H
+#define SPECULATIVE_BUILDER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "language_config.h"
+#include "compile_diagnostics.h"
+#include "admission_controller.h"
+
+struct SpeculativeBuild {
+    QString dir;          // Empty when no build matched
+    bool success = false;
+    QString error;        // Compiler output when success is false
+};
+
+// Compiles the editor contents in the background while the user is idle so
+// that Run can skip straight to the tests. Only one build is kept: a new
+// request cancels whatever is in flight and discards the previous result.
+class SpeculativeBuilder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SpeculativeBuilder(QObject *parent = nullptr);
+    ~SpeculativeBuilder();
+
+    static QByteArray sourceHash(const QString &code, const LanguageConfig &cfg);
+
+    // Builds wait for admission here and report their compiler's peak RSS
+    void setAdmission(AdmissionController *admission) { m_admission = admission; }
+
+    void request(const QString &code, const LanguageConfig &cfg);
+    void cancel();
+
+    // Whether take(hash) would hand over a build, finished or not
+    bool has(const QByteArray &hash) const;
+
+    // Hands over the build for hash, waiting up to waitMs if it is still
+    // compiling. The caller owns the returned directory.
+    SpeculativeBuild take(const QByteArray &hash, int waitMs);
+
+signals:
+    // sourceHash names the code they belong to; the editor may have moved on
+    void diagnosticsReady(const QByteArray &sourceHash, const QList<CompileDiagnostic> &diagnostics);
+
+private slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    void startCompile();
+    void releaseAdmission();
+    void discardReady();
+
+    QProcess *m_process = nullptr;
+    QTimer m_timeout;
+    QElapsedTimer m_elapsed;
+
+    AdmissionController *m_admission = nullptr;
+    qint64 m_admittedMB = 0;      // Reserved for the compile in flight
+    QTimer m_admissionRetry;      // A build that did not fit tries again
+    QTimer m_sampler;             // Samples the compiler's resident memory
+    qint64 m_peakRssKb = 0;
+
+    QByteArray m_pendingHash;
+    QString m_pendingDir;
+    LanguageConfig m_pendingCfg;
+
+    QByteArray m_readyHash;
+    SpeculativeBuild m_ready;
+};
+
+#endif // SPECULATIVE_BUILDER_H
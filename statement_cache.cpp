@@ -0,0 +1,247 @@
+#include "statement_cache.h"
+#include "problem_repository.h"
+
+#include <QJsonArray>
+#include <QMutexLocker>
+#include <QTextDocument>
+#include <QThread>
+#include <utility>
+
+namespace {
+
+// Base CSS for HTML content
+constexpr const char *BaseCss = R"(
+    * { margin: 0; padding: 0; }
+    body {
+        font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, sans-serif;
+        line-height: 1.7;
+        color: #aaa;
+    }
+    code {
+        background: #1a1a1a;
+        padding: 2px 7px;
+        border-radius: 4px;
+        color: #7dd3fc;
+        font-family: 'SF Mono', 'JetBrains Mono', monospace;
+        font-size: 0.9em;
+    }
+    strong, b { color: #ddd; font-weight: 600; }
+    em, i { color: #bbb; }
+
+    .io-line {
+        padding: 2px 0;
+        font-family: 'SF Mono', 'JetBrains Mono', monospace;
+    }
+    .io-line.comment {
+        color: #555;
+        font-style: italic;
+        font-size: 0.85em;
+    }
+    .io-line.highlight-green {
+        color: #4ade80;
+        font-weight: 600;
+    }
+    .io-line.highlight-red {
+        color: #f87171;
+        font-weight: 600;
+    }
+    .io-line.output {
+        color: #4ade80;
+    }
+
+    .input-table {
+        width: 100%;
+        border-collapse: collapse;
+    }
+    .input-table td {
+        padding: 6px 0;
+        vertical-align: top;
+    }
+    .input-table .line-num {
+        color: #666;
+        font-family: 'SF Mono', monospace;
+        font-size: 0.9em;
+        width: 100px;
+        padding-right: 12px;
+    }
+)";
+
+// Sample input and output
+constexpr const char *IoCss = R"(
+    body {
+        font-family: 'SF Mono', 'JetBrains Mono', monospace;
+        font-size: 13px;
+        line-height: 1.7;
+    }
+    .io-line { padding: 1px 0; }
+    .io-line.comment { color: #555; font-style: italic; font-size: 0.9em; }
+    .io-line.highlight-green {
+        display: inline-block;
+        background: rgba(74, 222, 128, 0.15);
+        color: #4ade80;
+        padding: 2px 8px;
+        border-radius: 4px;
+        font-weight: 600;
+    }
+    .io-line.highlight-red {
+        display: inline-block;
+        background: rgba(248, 113, 113, 0.15);
+        color: #f87171;
+        padding: 2px 8px;
+        border-radius: 4px;
+        font-weight: 600;
+    }
+    .io-line.output { color: #4ade80; }
+)";
+
+QString wrap(const QString &content, const QString &additionalCss = QString())
+{
+    return QString("<html><head><style>%1 %2</style></head><body>%3</body></html>")
+        .arg(QLatin1String(BaseCss), additionalCss, content);
+}
+
+// Parsed here, wherever that runs; deleted on the thread it ends up on
+Statement::Document document(const QString &html)
+{
+    auto *doc = new QTextDocument;
+    doc->setDocumentMargin(0);
+    doc->setHtml(html);
+    return Statement::Document(doc, [](QTextDocument *d) { d->deleteLater(); });
+}
+
+QString formatText(const QString &text)
+{
+    QString result = text;
+
+    // Replace \n with <br> for line breaks
+    result.replace("\\n", "<br>");
+    result.replace("\n", "<br>");
+
+    return result;
+}
+
+} // namespace
+
+QSharedPointer<const Statement> Statement::render(const QJsonObject &obj)
+{
+    auto s = QSharedPointer<Statement>::create();
+    s->id = obj["id"].toString();
+    s->title = obj["title"].toString();
+    s->difficulty = obj["difficulty"].toString();
+    s->category = obj["category"].toString();
+    for (const auto &tag : obj["tags"].toArray()) {
+        s->tags << tag.toString();
+    }
+
+    // Font sizes are in the CSS, so a document lays out the same in any view
+    s->description = document(wrap(formatText(obj["description"].toString()), "body { font-size: 14px; }"));
+    s->task = document(wrap(formatText(obj["task"].toString()), "body { color: #9ca3af; font-size: 14px; }"));
+    s->inputFormat = document(wrap(formatText(obj["inputFormat"].toString()),
+                                   "body { color: #999; font-size: 13px; }"));
+    s->outputFormat = document(wrap(formatText(obj["outputFormat"].toString()),
+                                    "body { color: #999; font-size: 13px; }"));
+
+    for (const auto &constraint : obj["constraints"].toArray()) {
+        s->constraints << QString("• %1").arg(constraint.toString());
+    }
+
+    const QString ioCss = QLatin1String(IoCss);
+    s->sampleInput = document(wrap(obj["sampleInput"].toString(), ioCss + " body { color: #7dd3fc; }"));
+    s->sampleOutput = document(wrap(obj["sampleOutput"].toString(), ioCss + " body { color: #4ade80; }"));
+
+    const QString sampleExplanation = obj["sampleExplanation"].toString();
+    if (!sampleExplanation.isEmpty()) {
+        QString explainCss = "body { color: #888; font-size: 13px; } code { background: #1a1a1a; color: #7dd3fc; }";
+        s->sampleExplanation = document(wrap(QString("💡 %1").arg(formatText(sampleExplanation)), explainCss));
+    }
+
+    int hintNum = 1;
+    for (const auto &hint : obj["hints"].toArray()) {
+        s->hints << QString("<span style='color:#60a5fa;font-weight:600;'>%1.</span> %2")
+                        .arg(hintNum++)
+                        .arg(hint.toString());
+    }
+    return s;
+}
+
+void Statement::moveToThread(QThread *thread) const
+{
+    for (const Document &doc : {description, task, inputFormat, outputFormat,
+                                sampleInput, sampleOutput, sampleExplanation}) {
+        if (doc) doc->moveToThread(thread);
+    }
+}
+
+StatementCache::StatementCache(ProblemRepository *repository, QObject *parent)
+    : QObject(parent), m_repository(repository)
+{
+    m_cache.setMaxCost(MaxStatements);
+}
+
+StatementCache::~StatementCache()
+{
+    stop();
+    // Its finished() never reached us
+    delete m_worker;
+}
+
+void StatementCache::stop()
+{
+    m_stopped = true;
+    m_pending.clear();
+    // The worker only reads the problem and fills the cache; let it land
+    if (m_worker) m_worker->wait();
+}
+
+QSharedPointer<const Statement> StatementCache::get(quint64 contentHash, const QJsonObject &problem)
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (auto *cached = m_cache.object(contentHash)) return *cached;
+    }
+
+    auto statement = Statement::render(problem);
+    insert(contentHash, statement);
+    return statement;
+}
+
+void StatementCache::prefetch(const QString &filePath)
+{
+    if (m_stopped) return;
+    if (m_worker) {
+        m_pending = filePath;
+        return;
+    }
+    start(filePath);
+}
+
+void StatementCache::start(const QString &filePath)
+{
+    QThread *gui = thread();
+    m_worker = QThread::create([this, filePath, gui]() {
+        // Parsed through the repository, so opening it later is a hit there
+        // too; the tests are left for whoever opens it
+        const ProblemRepository::Problem problem = m_repository->problem(filePath, false);
+        if (!problem.isValid()) return;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_cache.contains(problem.contentHash)) return;
+        }
+        // Pushed to the GUI thread before anyone there can see them
+        const auto statement = Statement::render(problem.root);
+        statement->moveToThread(gui);
+        insert(problem.contentHash, statement);
+    });
+    connect(m_worker, &QThread::finished, this, [this]() {
+        m_worker->deleteLater();
+        m_worker = nullptr;
+        if (!m_pending.isEmpty()) start(std::exchange(m_pending, {}));
+    });
+    m_worker->start(QThread::LowPriority);
+}
+
+void StatementCache::insert(quint64 contentHash, const QSharedPointer<const Statement> &statement)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.insert(contentHash, new QSharedPointer<const Statement>(statement));
+}
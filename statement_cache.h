@@ -0,0 +1,73 @@
+#ifndef STATEMENT_CACHE_H
+#define STATEMENT_CACHE_H
+
+#include <QCache>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+class ProblemRepository;
+class QTextDocument;
+class QThread;
+
+// A problem statement as ProblemPanel shows it: one parsed document per
+// rich-text section, for a StatementView, and the text of every tag,
+// constraint and hint. QTextDocument needs no GUI thread, so rendering can
+// run on a worker; moveToThread() hands the documents to the GUI thread.
+struct Statement {
+    using Document = QSharedPointer<QTextDocument>;
+
+    QString id;
+    QString title;
+    QString difficulty;          // As written, e.g. "Medium"
+    QString category;
+    QStringList tags;
+    Document description;
+    Document task;
+    Document inputFormat;
+    Document outputFormat;
+    QStringList constraints;
+    Document sampleInput;
+    Document sampleOutput;
+    Document sampleExplanation;  // Null when the problem has none
+    QStringList hints;
+
+    static QSharedPointer<const Statement> render(const QJsonObject &problem);
+    void moveToThread(QThread *thread) const;
+};
+
+// Rendered statements keyed by the content hash of their problem file, so
+// revisiting a problem skips parsing its HTML and an edited file gets a
+// new entry. prefetch() renders a problem on a background thread, meant
+// for the one the user is likely to open next. The worker reads through
+// the repository, so stop() has to run before that is destroyed.
+class StatementCache : public QObject {
+    Q_OBJECT
+public:
+    explicit StatementCache(ProblemRepository *repository, QObject *parent = nullptr);
+    ~StatementCache();
+
+    QSharedPointer<const Statement> get(quint64 contentHash, const QJsonObject &problem);
+    // Only the latest request waits while one is being rendered
+    void prefetch(const QString &filePath);
+    // Drops the waiting request and waits for the running one; prefetch()
+    // does nothing afterwards
+    void stop();
+
+private:
+    static constexpr int MaxStatements = 64;
+
+    void start(const QString &filePath);
+    void insert(quint64 contentHash, const QSharedPointer<const Statement> &statement);
+
+    ProblemRepository *m_repository;
+    QMutex m_mutex;
+    QCache<quint64, QSharedPointer<const Statement>> m_cache;
+    QThread *m_worker = nullptr;
+    QString m_pending;
+    bool m_stopped = false;
+};
+
+#endif // STATEMENT_CACHE_H
@@ -0,0 +1,53 @@
+#include "statement_view.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QDesktopServices>
+#include <QTextDocument>
+#include <cmath>
+
+StatementView::StatementView(QWidget *parent)
+    : QTextBrowser(parent), m_blank(new QTextDocument(this))
+{
+    setFrameShape(QFrame::NoFrame);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+    setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::LinksAccessibleByMouse);
+    viewport()->setAutoFillBackground(false);
+
+    // The documents are shared with the cache; following a link in place
+    // would load another page into them
+    setOpenLinks(false);
+    connect(this, &QTextBrowser::anchorClicked, this, [](const QUrl &url) {
+        QDesktopServices::openUrl(url);
+    });
+
+    setDocument(m_blank);
+}
+
+void StatementView::showDocument(const QSharedPointer<QTextDocument> &document)
+{
+    if (document == m_document) return;
+
+    QTextDocument *shown = document ? document.get() : m_blank;
+    disconnect(this->document()->documentLayout(), nullptr, this, nullptr);
+    setDocument(shown);
+    m_document = document;
+
+    connect(shown->documentLayout(), &QAbstractTextDocumentLayout::documentSizeChanged,
+            this, &StatementView::fitHeight);
+    fitHeight();
+}
+
+void StatementView::resizeEvent(QResizeEvent *event)
+{
+    QTextBrowser::resizeEvent(event);
+    fitHeight();
+}
+
+void StatementView::fitHeight()
+{
+    const QMargins margins = contentsMargins() + viewportMargins();
+    const int height = int(std::ceil(document()->size().height())) + margins.top() + margins.bottom();
+    if (height != this->height()) setFixedHeight(height);
+}
@@ -0,0 +1,33 @@
+#ifndef STATEMENT_VIEW_H
+#define STATEMENT_VIEW_H
+
+#include <QSharedPointer>
+#include <QTextBrowser>
+
+class QTextDocument;
+
+// Read-only view of one section of a problem statement. It shows a
+// document from the StatementCache as is, its HTML parsed already, instead
+// of parsing it on every setText() the way a QLabel does; the view lays it
+// out at its own width when shown. The view is as tall as its document and
+// never scrolls; the panel does.
+class StatementView : public QTextBrowser {
+    Q_OBJECT
+public:
+    explicit StatementView(QWidget *parent = nullptr);
+
+    // Kept alive while shown, even if the cache drops it meanwhile; null
+    // shows nothing
+    void showDocument(const QSharedPointer<QTextDocument> &document);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void fitHeight();
+
+    QSharedPointer<QTextDocument> m_document;
+    QTextDocument *m_blank;
+};
+
+#endif // STATEMENT_VIEW_H
@@ -0,0 +1,60 @@
+#include "test_case_set.h"
+
+#include <QJsonValue>
+
+TestCases TestCaseSet::fromJson(const QJsonArray &tests) {
+    auto set = QSharedPointer<TestCaseSet>::create();
+    set->m_tests.reserve(tests.size());
+    for (const QJsonValue &value : tests) {
+        const QJsonObject test = value.toObject();
+        TestCase tc;
+        tc.input = input(test);
+        tc.expected = test.value("output").toString().toUtf8();
+        if (tc.expected.size() >= DigestBytes) {
+            tc.digestOnly = true;
+            tc.digest = OutputNormalizer::digest(tc.expected);
+        }
+        tc.sample = test.value("sample").toBool();
+        tc.max = test.value("max").toBool();
+        tc.extended = test.value("tier").toString() == "extended";
+        set->m_bytes += tc.input.size() + tc.expected.size();
+        set->m_tests.append(tc);
+    }
+    return set;
+}
+
+QByteArray TestCaseSet::input(const QJsonObject &test) {
+    // Handle both array and string input formats; built as UTF-8 once,
+    // which is what every runner feeds the solution
+    QByteArray input;
+
+    const QJsonValue inputVal = test.value("input");
+    if (inputVal.isArray()) {
+        for (const QJsonValue &arg : inputVal.toArray()) {
+            input += arg.toString().toUtf8() + '\n';
+        }
+    } else if (inputVal.isString()) {
+        input = inputVal.toString().toUtf8();
+        if (!input.endsWith('\n')) {
+            input += '\n';
+        }
+    }
+    return input;
+}
+
+QString TestCaseSet::preview(QByteArrayView bytes, qsizetype limit) {
+    if (bytes.size() <= limit) return QString::fromUtf8(bytes).trimmed();
+
+    // Cut before a character the limit would split, not through it; a
+    // sequence is at most 4 bytes, so this looks back 3 at most
+    qsizetype cut = limit;
+    for (qsizetype i = limit; i > 0 && i > limit - 4; --i) {
+        const uchar c = uchar(bytes[i]);
+        if ((c & 0xc0) != 0x80) {
+            cut = i;
+            break;
+        }
+    }
+    return QString::fromUtf8(bytes.first(cut)).trimmed() +
+           QString("\n... (%1 bytes, truncated)").arg(bytes.size());
+}
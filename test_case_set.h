@@ -0,0 +1,59 @@
+#ifndef TEST_CASE_SET_H
+#define TEST_CASE_SET_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include "output_normalizer.h"
+
+class TestCaseSet;
+
+// Shared, read-only handle; copies only bump the reference count
+using TestCases = QSharedPointer<const TestCaseSet>;
+
+// The tests of one version of a problem, parsed once from its "testCases"
+// and never changed afterwards. ProblemRepository caches one per problem
+// file; the problem panel, the test case panel and the runner all hold the
+// same instance. Inputs and expected outputs are kept as UTF-8 bytes only,
+// the form solutions are fed and judged in; widgets take preview() copies.
+class TestCaseSet {
+public:
+    struct TestCase {
+        QByteArray input;      // Fed to the solution as is, ends in '\n'
+        QByteArray expected;   // UTF-8
+        // Large expected outputs key the result cache by digest, worked out
+        // here once per version of the problem rather than on every run
+        bool digestOnly = false;
+        OutputNormalizer::Digest digest;
+        bool sample = false;   // "sample": shown in the statement
+        bool max = false;      // "max": a worst-case test
+        bool extended = false; // "tier": "extended"
+    };
+
+    // Display copies are cut to this many bytes
+    static constexpr qsizetype PreviewBytes = 4 * 1024;
+    // Expected outputs at least this large are cached by digest
+    static constexpr qsizetype DigestBytes = 1024 * 1024;
+
+    static TestCases fromJson(const QJsonArray &tests);
+
+    // The stdin a test case feeds the solution
+    static QByteArray input(const QJsonObject &test);
+    static QString preview(QByteArrayView bytes, qsizetype limit = PreviewBytes);
+
+    int size() const { return int(m_tests.size()); }
+    bool isEmpty() const { return m_tests.isEmpty(); }
+    const TestCase &at(int index) const { return m_tests.at(index); }
+    // Bytes held by inputs and expected outputs together
+    qint64 bytes() const { return m_bytes; }
+
+private:
+    QList<TestCase> m_tests;
+    qint64 m_bytes = 0;
+};
+
+#endif // TEST_CASE_SET_H
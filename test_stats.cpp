@@ -0,0 +1,79 @@
+#include "test_stats.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QDebug>
+
+TestStats::TestStats(const QString &filePath) : m_filePath(filePath) {
+    if (m_filePath.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_filePath = dir + "/test_stats.json";
+    }
+}
+
+TestStats::Entry TestStats::lookup(const QString &problem, const QByteArray &testKey) const {
+    return m_problems.value(problem).value(testKey);
+}
+
+void TestStats::record(const QString &problem, const QByteArray &testKey, bool failed, qint64 timeMs) {
+    Entry &entry = m_problems[problem][testKey];
+    if (entry.runs >= MaxRuns) {
+        entry.runs /= 2;
+        entry.failures /= 2;
+        entry.totalMs /= 2;
+    }
+    entry.runs++;
+    if (failed) entry.failures++;
+    entry.totalMs += qMax<qint64>(0, timeMs);
+    m_dirty = true;
+}
+
+void TestStats::load() {
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    m_problems.clear();
+    for (auto p = root.begin(); p != root.end(); ++p) {
+        const QJsonObject tests = p.value().toObject();
+        QHash<QByteArray, Entry> &entries = m_problems[p.key()];
+        for (auto t = tests.begin(); t != tests.end(); ++t) {
+            const QJsonArray values = t.value().toArray();
+            Entry entry;
+            entry.runs = values.at(0).toInt();
+            entry.failures = values.at(1).toInt();
+            entry.totalMs = values.at(2).toInteger();
+            entries.insert(t.key().toLatin1(), entry);
+        }
+    }
+    m_dirty = false;
+}
+
+void TestStats::save() {
+    if (!m_dirty) return;
+
+    QJsonObject root;
+    for (auto p = m_problems.begin(); p != m_problems.end(); ++p) {
+        QJsonObject tests;
+        for (auto t = p->begin(); t != p->end(); ++t) {
+            tests[QString::fromLatin1(t.key())] = QJsonArray{t->runs, t->failures, t->totalMs};
+        }
+        root[p.key()] = tests;
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save test statistics:" << m_filePath;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (file.commit()) m_dirty = false;
+}
@@ -0,0 +1,44 @@
+#ifndef TEST_STATS_H
+#define TEST_STATS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+
+// How each test of a problem has fared across submissions: how often it ran,
+// how often it failed and how long it took. Submit uses this to run the
+// tests most likely to fail, per unit of time, first. Tests are keyed by
+// their content, so editing or reordering a problem's tests keeps the
+// history of the ones that did not change. Persisted as JSON in the app
+// data directory.
+class TestStats {
+public:
+    struct Entry {
+        int runs = 0;
+        int failures = 0;
+        qint64 totalMs = 0;
+    };
+
+    explicit TestStats(const QString &filePath = QString());
+
+    Entry lookup(const QString &problem, const QByteArray &testKey) const;
+    void record(const QString &problem, const QByteArray &testKey, bool failed, qint64 timeMs);
+
+    // Laplace-smoothed failure rate, so an unseen test counts as a coin flip
+    static double failureRate(const Entry &entry) {
+        return (entry.failures + 1.0) / (entry.runs + 2.0);
+    }
+
+    void load();
+    void save();
+
+private:
+    // Old counts are halved past this so the order follows recent behaviour
+    static constexpr int MaxRuns = 64;
+
+    QHash<QString, QHash<QByteArray, Entry>> m_problems;
+    QString m_filePath;
+    bool m_dirty = false;
+};
+
+#endif // TEST_STATS_H
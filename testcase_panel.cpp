@@ -324,12 +324,12 @@ void TestCasePanel::updateContent(int index)
         resultStatusLabel->setProperty("status", "running");
         outputValueLabel->setText("...");
     } else if (data.status == TestCaseData::Passed) {
-        resultStatusLabel->setText("✓ Accepted");
+        resultStatusLabel->setText(data.cached ? "✓ Accepted (cached)" : "✓ Accepted");
         resultStatusLabel->setProperty("status", "passed");
         outputValueLabel->setText(formatCode(data.actualOutput));
         outputValueLabel->setTextFormat(Qt::RichText);
     } else {
-        resultStatusLabel->setText("✗ Wrong Answer");
+        resultStatusLabel->setText(data.cached ? "✗ Wrong Answer (cached)" : "✗ Wrong Answer");
         resultStatusLabel->setProperty("status", "failed");
         outputValueLabel->setText(formatCode(data.actualOutput));
         outputValueLabel->setTextFormat(Qt::RichText);
@@ -341,17 +341,18 @@ void TestCasePanel::updateContent(int index)
     resultStatusLabel->style()->polish(resultStatusLabel);
 }
 
-void TestCasePanel::loadTestCases(const QJsonArray &testCases)
+void TestCasePanel::loadTestCases(const TestCases &testCases)
 {
     clearTestCases();
+    if (!testCases) return;
 
     int caseNum = 0;
-    for (const auto &tc : testCases) {
-        QJsonObject testCase = tc.toObject();
+    for (int i = 0; i < testCases->size(); ++i) {
+        const TestCaseSet::TestCase &testCase = testCases->at(i);
 
         TestCaseData data;
-        data.input = testCase["input"].toString();
-        data.expectedOutput = testCase["output"].toString();
+        data.input = TestCaseSet::preview(testCase.input);
+        data.expectedOutput = TestCaseSet::preview(testCase.expected);
         data.status = TestCaseData::Pending;
 
         testCaseData[caseNum] = data;
@@ -386,7 +387,11 @@ void TestCasePanel::setTestResult(int caseIndex, const QString &actualOutput, bo
     QString tabText = passed
                           ? QString("✓ Case %1").arg(caseIndex + 1)
                           : QString("✗ Case %1").arg(caseIndex + 1);
+    if (testCaseData[caseIndex].cached) tabText += " ·";
     caseTabBar->setTabText(caseIndex, tabText);
+    caseTabBar->setTabToolTip(caseIndex, testCaseData[caseIndex].cached
+                                             ? "Cached result (Ctrl+Shift+R to re-run)"
+                                             : QString());
 
     // If viewing this case, update display
     if (caseIndex == currentCaseIndex) {
@@ -403,6 +408,7 @@ void TestCasePanel::setTestRunning(int caseIndex)
 
     testCaseData[caseIndex].status = TestCaseData::Running;
     testCaseData[caseIndex].actualOutput.clear();
+    testCaseData[caseIndex].cached = false;
     caseTabBar->setTabText(caseIndex, QString("◌ Case %1").arg(caseIndex + 1));
 
     if (caseIndex == currentCaseIndex) {
@@ -412,12 +418,22 @@ void TestCasePanel::setTestRunning(int caseIndex)
     showResultView();
 }
 
+void TestCasePanel::setTestCached(int caseIndex)
+{
+    if (!testCaseData.contains(caseIndex)) return;
+
+    // Flag only; the verdict itself arrives through setTestResult()
+    testCaseData[caseIndex].cached = true;
+}
+
 void TestCasePanel::clearAllResults()
 {
     for (int i = 0; i < testCaseData.size(); ++i) {
         testCaseData[i].actualOutput.clear();
         testCaseData[i].status = TestCaseData::Pending;
+        testCaseData[i].cached = false;
         caseTabBar->setTabText(i, QString("Case %1").arg(i + 1));
+        caseTabBar->setTabToolTip(i, QString());
     }
 
     updateContent(currentCaseIndex);
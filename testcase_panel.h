@@ -10,12 +10,16 @@
 #include <QJsonObject>
 #include <QVBoxLayout>
 #include <QMap>
+#include "test_case_set.h"
 
+// What the panel shows of a test; input and expected output are previews
+// cut to TestCaseSet::PreviewBytes, the full data stays in the shared set
 struct TestCaseData {
     QString input;
     QString expectedOutput;
     QString actualOutput;
     enum Status { Pending, Running, Passed, Failed } status = Pending;
+    bool cached = false;   // Result reused from a previous identical run
 };
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -27,11 +31,12 @@ class TestCasePanel : public QWidget {
 public:
     explicit TestCasePanel(QWidget *parent = nullptr);
 
-    void loadTestCases(const QJsonArray &testCases);
+    void loadTestCases(const TestCases &testCases);
     void clearTestCases();
 
     void setTestResult(int caseIndex, const QString &actualOutput, bool passed);
     void setTestRunning(int caseIndex);
+    void setTestCached(int caseIndex);
     void clearAllResults();
     void resetTestResult(int index);
 